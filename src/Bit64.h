@@ -0,0 +1,104 @@
+#ifndef BIT64_H_
+#define BIT64_H_
+
+#include "Bit.h"
+
+// 64 Bits at once (one for each of 64 independent patterns).
+// Pattern k is bit k of two words: `def` is set if the bit is defined,
+// and `val` is the bit value (always 0 if the bit is undefined).
+// The operators work like the Bit operators on every pattern.
+struct Bit64
+{
+	uint64_t val;
+	uint64_t def;
+
+	// all patterns are UNDEF
+	Bit64() : val(0), def(0) {}
+	// all patterns are the same bit
+	Bit64(Bit b) :
+		 val(b == Bit(HIGH) ? ~(uint64_t)0 : 0)
+		,def(b.isDefined() ? ~(uint64_t)0 : 0)
+	{}
+	// from the two words
+	Bit64(uint64_t v, uint64_t d) : val(v & d), def(d) {}
+
+	// get random bits (HIGH/LOW)
+	static inline Bit64 random()
+	{
+		uint64_t v = ((uint64_t)::random() << 62) ^ ((uint64_t)::random() << 31) ^ (uint64_t)::random();
+		return Bit64(v, ~(uint64_t)0);
+	}
+
+	// get/set pattern k
+	inline Bit get(int k) const
+	{
+		if (!((def >> k) & 1)) return Bit(UNDEF);
+		return Bit(((val >> k) & 1) ? HIGH : LOW);
+	}
+
+	inline void set(int k, Bit b)
+	{
+		uint64_t m = (uint64_t)1 << k;
+		val &= ~m;
+		def &= ~m;
+		if (b == Bit(HIGH)) val |= m;
+		if (b.isDefined()) def |= m;
+	}
+
+	// patterns that are HIGH or LOW
+	inline uint64_t high() const { return val; }
+	inline uint64_t low() const { return def & ~val; }
+
+	// a LOW input forces AND to LOW, a HIGH input forces OR to HIGH
+
+	inline Bit64 operator&(const Bit64& other) const
+	{
+		uint64_t h = high() & other.high();
+		return Bit64(h, h | low() | other.low());
+	}
+
+	inline Bit64 operator|(const Bit64& other) const
+	{
+		uint64_t h = high() | other.high();
+		return Bit64(h, h | (low() & other.low()));
+	}
+
+	inline Bit64 operator^(const Bit64& other) const
+	{
+		return Bit64(val ^ other.val, def & other.def);
+	}
+
+	inline Bit64 operator~() const
+	{
+		return Bit64(~val, def);
+	}
+
+	inline bool operator==(const Bit64& other) const
+	{
+		return val == other.val && def == other.def;
+	}
+
+	inline bool operator!=(const Bit64& other) const
+	{
+		return !(*this == other);
+	}
+
+	// bitwise methods that modify these Bits
+
+	inline Bit64& AND(const Bit64& other)  { return *this = *this & other; }
+	inline Bit64& OR(const Bit64& other)   { return *this = *this | other; }
+	inline Bit64& XOR(const Bit64& other)  { return *this = *this ^ other; }
+	inline Bit64& NOT()                    { return *this = ~*this; }
+	inline Bit64& NAND(const Bit64& other) { return *this = ~(*this & other); }
+	inline Bit64& NOR(const Bit64& other)  { return *this = ~(*this | other); }
+	inline Bit64& XNOR(const Bit64& other) { return *this = ~(*this ^ other); }
+
+	// `a` where sel is LOW, `b` where sel is HIGH, otherwise UNDEF
+	static inline Bit64 mux(const Bit64& sel, const Bit64& a, const Bit64& b)
+	{
+		uint64_t l = sel.low(), h = sel.high();
+		return Bit64((l & a.val) | (h & b.val), (l & a.def) | (h & b.def));
+	}
+};
+
+#endif // BIT64_H_
@@ -1,8 +1,9 @@
 #ifndef BITHISTORY_H_
 #define BITHISTORY_H_
 
-#include <set>
+#include <vector>
 #include <utility>
+#include <algorithm>
 #include <climits>
 #include "Bit.h"
 
@@ -21,16 +22,30 @@ struct HPAIRcmp
 		return p1.first < p2.first;
 	}
 };
-typedef std::set<HPAIR_T,HPAIRcmp> HSET_T;
-typedef HSET_T::const_iterator HITER_T;
+typedef std::vector<HPAIR_T> HVEC_T;
+typedef HVEC_T::const_iterator HITER_T;
 
 // BitHistory is a record of changes (time,value) pairs for some Bit signal
+// The pairs are kept in a vector sorted by time.
+// Almost all reads and writes happen at or after the latest time,
+// so the latest pair is cached and those are O(1).
+// Reads and writes in the past use binary search.
 class BitHistory
 {
 private:
-	HSET_T history_;
+	HVEC_T history_;
+	// copy of the latest pair (time is DELAY_T_MIN if there is none)
+	HPAIR_T last_;
+
+	// first pair with time > T
+	HVEC_T::iterator after(delay_t T)
+	{
+		return std::upper_bound(history_.begin(), history_.end(), HPAIR_T(T,Bit()), HPAIRcmp());
+	}
 
 public:
+	BitHistory() : last_(DELAY_T_MIN,Bit()) {}
+
 	// Get the (time,value) pair for time T.
 	// Note that the actual time returned can be < T.
 	const HPAIR_T& getPair(delay_t T) const
@@ -38,28 +53,19 @@ public:
 		static const Bit bitundef;
 		static const HPAIR_T undef(DELAY_T_MIN,bitundef);
 
-		// iter points to some time >= T
-		HITER_T iter = history_.lower_bound(HPAIR_T(T,bitundef));
+		// T is at or after the latest recorded time
+		// (also covers an empty history, since last_ is undefined)
+		if (T >= last_.first)
+			return last_;
 
-		// T was past the biggest recorded time
-		if (iter == history_.end())
-		{
-			// no values present
-			if (history_.size() < 1)
-				return undef;
-			// return latest bit
-			return *(history_.rbegin());
-		}
+		// find first element with time > T
+		HITER_T iter = std::upper_bound(history_.begin(), history_.end(), HPAIR_T(T,bitundef), HPAIRcmp());
 
-		// found exact T
-		if ((*iter).first == T)
-			return *iter;
-
-		// we found first element and it's > T
+		// every element is > T
 		if (iter == history_.begin())
 			return undef;
 
-		// return previous bit (time < T)
+		// return previous bit (time <= T)
 		iter--;
 		return *iter;
 	}
@@ -73,20 +79,42 @@ public:
 	// Set the value at time T
 	bool set(Bit b, delay_t T)
 	{
-		// get the value at time T
-		const HPAIR_T& p = getPair(T);
+		// append at the end of the history
+		if (T >= last_.first)
+		{
+			// value did not change
+			if (last_.second == b)
+				return false;
+			// if record was actually at time T, replace it
+			if (T == last_.first && !history_.empty())
+				history_.back().second = b;
+			else
+				history_.push_back(HPAIR_T(T,b));
+			last_ = history_.back();
+			return true;
+		}
 
-		// if new value is different
-		if (p.second != b)
+		// insert in the past
+		HVEC_T::iterator iter = after(T);
+		if (iter != history_.begin())
 		{
-			// if record was actually at time T, remove it
-			if (p.first == T)
-				history_.erase(p);
-			// add new value
-			history_.insert(HPAIR_T(T,b));
+			HVEC_T::iterator prev = iter - 1;
+			// value did not change
+			if (prev->second == b)
+				return false;
+			// if record was actually at time T, replace it
+			if (prev->first == T)
+			{
+				prev->second = b;
+				return true;
+			}
 		}
-		// value did not change
-		else return false;
+		// value before first record is undefined
+		else if (b == Bit())
+			return false;
+
+		// add new value
+		history_.insert(iter, HPAIR_T(T,b));
 
 		// bit was changed for time T
 		return true;
@@ -101,14 +129,30 @@ public:
 	// Last (latest) time in the history
 	delay_t lastTime() const
 	{
-		return (history_.size() > 0) ? (*(history_.rbegin())).first : DELAY_T_MIN;
+		return last_.first;
+	}
+
+	// Forget all values before the value at time T
+	// (the value at time T and all later values are kept)
+	void forget(delay_t T)
+	{
+		int k = 0, N = history_.size();
+		while (k+1 < N && history_[k+1].first <= T) k++;
+		if (k) history_.erase(history_.begin(), history_.begin()+k);
 	}
 
 	// Number of entries in the history
 	int size() const { return (int)history_.size(); }
 
+	// Exchange contents with another history
+	void swap(BitHistory& other)
+	{
+		history_.swap(other.history_);
+		std::swap(last_, other.last_);
+	}
+
 	// Clear the history
-	void clear() { history_.clear(); }
+	void clear() { history_.clear(); last_ = HPAIR_T(DELAY_T_MIN,Bit()); }
 
 	// Get iterators to the beginning and end of the history
 	HITER_T begin() const { return history_.begin(); }
@@ -1,57 +1,61 @@
 #include "BitVector.h"
 #include "Module.h"
 
-BitVector::BitVector(int width)
+// number of words for N bits
+#define NWORDS(N) (((N) + 63) / 64)
+
+BitVector::BitVector(int width) :
+	 words_(NWORDS(width))
+	,width_(width)
 {
 	assert(width > 0);
-	bits_.resize(width);
 }
 
-BitVector::BitVector(Bit b)
+BitVector::BitVector(Bit b) :
+	 words_(1)
+	,width_(1)
 {
-	bits_.push_back(b);
+	words_[0].set(0, b);
 }
 
-BitVector::BitVector(int width, value_t val)
+BitVector::BitVector(int width, value_t val) :
+	 words_(1)
+	,width_(width)
 {
 	assert(width > 0 && width <= VALUE_T_BITS);
-	bits_.reserve(width);
-
-	for (int i = 0; i < width; i++, val >>= 1)
-		bits_.push_back(Bit(val & 1));
+	uint64_t mask = ~(uint64_t)0 >> (64 - width);
+	words_[0] = Bit64(val, mask);
 }
 
-BitVector::BitVector(const std::string& s)
+BitVector::BitVector(const std::string& s) :
+	 words_(NWORDS(s.length()))
+	,width_(s.length())
 {
-	int L = s.length();
+	int L = width_;
 	assert(L > 0);
-	bits_.reserve(L);
 
-	for (int i = L-1; i >= 0; i--)
+	for (int i = 0; i < L; i++)
 	{
-		switch (s[i])
+		switch (s[L-1-i])
 		{
-		case '0': bits_.push_back(Bit(LOW));  break;
-		case '1': bits_.push_back(Bit(HIGH)); break;
-		case 'x': bits_.push_back(Bit());     break;
+		case '0': set(i, Bit(LOW));  break;
+		case '1': set(i, Bit(HIGH)); break;
+		case 'x': break;
 		default:  assert(0);
 		}
 	}
 }
 
-BitVector::BitVector(const Port& p)
+BitVector::BitVector(const Port& p) :
+	 words_(NWORDS(p.width()))
+	,width_(p.width())
 {
 	assert(p.module);
-	int N = p.width();
+	int N = width_;
 	assert(N > 0);
 
-	bits_.reserve(N);
-
-	for (int i = p.low; i <= p.high; i++)
-	{
-		Bit b = p.module->getInput(i, Module::simTime());
-		bits_.push_back(b);
-	}
+	for (int i = 0; i < N; i++)
+		set(i, p.module->getInput(p.low+i, Module::simTime()));
 }
 
 // static method
@@ -77,22 +81,16 @@ BitVector& BitVector::operator=(const Port& p)
 	assert(N > 0);
 	assert(N == width());
 
-	for (int i = 0; i <= N; i++)
-		bits_[i] = p.module->getInput(p.low+i, Module::simTime());
+	for (int i = 0; i < N; i++)
+		set(i, p.module->getInput(p.low+i, Module::simTime()));
 
 	return *this;
 }
 
 bool BitVector::operator==(const BitVector& other) const
 {
-	int N = other.width();
-	assert(N == width());
-
-	for (int i = 0; i < N; i++)
-		if (bits_[i] != other.get(i))
-			return false;
-
-	return true;
+	assert(other.width() == width());
+	return words_ == other.words_;
 }
 
 
@@ -103,118 +101,94 @@ bool BitVector::operator!=(const BitVector& other) const
 
 BitVector BitVector::operator&(const BitVector& other) const
 {
-	int N = other.width();
-	assert(N == width());
-
-	BitVector vec(N);
-	for (int i = 0; i < N; i++)
-		vec.set(i, bits_[i] & other.get(i));
-	return vec;
+	BitVector vec(*this);
+	return vec.AND(other);
 }
 
 BitVector BitVector::operator|(const BitVector& other) const
 {
-	int N = other.width();
-	assert(N == width());
-
-	BitVector vec(N);
-	for (int i = 0; i < N; i++)
-		vec.set(i, bits_[i] | other.get(i));
-	return vec;
+	BitVector vec(*this);
+	return vec.OR(other);
 }
 
 BitVector BitVector::operator^(const BitVector& other) const
 {
-	int N = other.width();
-	assert(N == width());
-
-	BitVector vec(N);
-	for (int i = 0; i < N; i++)
-		vec.set(i, bits_[i] ^ other.get(i));
-	return vec;
+	BitVector vec(*this);
+	return vec.XOR(other);
 }
 
 BitVector BitVector::operator~() const
 {
-	int N = width();
-	BitVector vec(N);
-	for (int i = 0; i < N; i++)
-		vec.set(i, ~bits_[i]);
-	return vec;
+	BitVector vec(*this);
+	return vec.NOT();
 }
 
+// the 64-bit operators keep the bits past the width UNDEF
+
 BitVector& BitVector::AND(const BitVector& other)
 {
-	int N = other.width();
-	assert(N == width());
+	assert(other.width() == width());
 
-	for (int i = 0; i < N; i++)
-		bits_[i].AND(other.get(i));
+	for (size_t w = 0; w < words_.size(); w++)
+		words_[w].AND(other.words_[w]);
 
 	return *this;
 }
 
 BitVector& BitVector::NAND(const BitVector& other)
 {
-	int N = other.width();
-	assert(N == width());
+	assert(other.width() == width());
 
-	for (int i = 0; i < N; i++)
-		bits_[i].NAND(other.get(i));
+	for (size_t w = 0; w < words_.size(); w++)
+		words_[w].NAND(other.words_[w]);
 
 	return *this;
 }
 
 BitVector& BitVector::OR(const BitVector& other)
 {
-	int N = other.width();
-	assert(N == width());
+	assert(other.width() == width());
 
-	for (int i = 0; i < N; i++)
-		bits_[i].OR(other.get(i));
+	for (size_t w = 0; w < words_.size(); w++)
+		words_[w].OR(other.words_[w]);
 
 	return *this;
 }
 
 BitVector& BitVector::NOR(const BitVector& other)
 {
-	int N = other.width();
-	assert(N == width());
+	assert(other.width() == width());
 
-	for (int i = 0; i < N; i++)
-		bits_[i].NOR(other.get(i));
+	for (size_t w = 0; w < words_.size(); w++)
+		words_[w].NOR(other.words_[w]);
 
 	return *this;
 }
 
 BitVector& BitVector::XOR(const BitVector& other)
 {
-	int N = other.width();
-	assert(N == width());
+	assert(other.width() == width());
 
-	for (int i = 0; i < N; i++)
-		bits_[i].XOR(other.get(i));
+	for (size_t w = 0; w < words_.size(); w++)
+		words_[w].XOR(other.words_[w]);
 
 	return *this;
 }
 
 BitVector& BitVector::XNOR(const BitVector& other)
 {
-	int N = other.width();
-	assert(N == width());
+	assert(other.width() == width());
 
-	for (int i = 0; i < N; i++)
-		bits_[i].XNOR(other.get(i));
+	for (size_t w = 0; w < words_.size(); w++)
+		words_[w].XNOR(other.words_[w]);
 
 	return *this;
 }
 
 BitVector& BitVector::NOT()
 {
-	int N = width();
-
-	for (int i = 0; i < N; i++)
-		bits_[i].NOT();
+	for (size_t w = 0; w < words_.size(); w++)
+		words_[w].NOT();
 
 	return *this;
 }
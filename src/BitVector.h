@@ -3,15 +3,20 @@
 
 #include <vector>
 #include "Bit.h"
+#include "Bit64.h"
 
 // defined in Module.h
 struct Port;
 
 // array of Bits
+// The bits are packed 64 to a word (see Bit64), so the bitwise operators
+// work on 64 bits at a time. Bits past the width are always UNDEF.
 class BitVector
 {
 private:
-	std::vector<Bit> bits_;
+	// bit i is bit i%64 of word i/64
+	std::vector<Bit64> words_;
+	int width_;
 
 public:
 	// create vector with specified width (bit values are UNDEF)
@@ -30,11 +35,11 @@ public:
 	static BitVector random(int N);
 
 	// get width
-	int width() const { return bits_.size(); }
+	int width() const { return width_; }
 	// get bit i
-	Bit get(int i = 0) const { return bits_.at(i); }
+	Bit get(int i = 0) const { assert(i >= 0 && i < width_); return words_[i >> 6].get(i & 63); }
 	// set bit i
-	void set(int i, const Bit& b) { bits_.at(i) = b; }
+	void set(int i, const Bit& b) { assert(i >= 0 && i < width_); words_[i >> 6].set(i & 63, b); }
 	// set bit 0
 	void set(const Bit& b) { set(0, b); }
 
@@ -36,7 +36,7 @@ public:
 
 		std::stringstream ss;
 		ss << "CLK<" << Ncycle << "," << highT << "," << lowT << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		addOutputs(1);
 	}
@@ -0,0 +1,176 @@
+#include <fstream>
+#include <sstream>
+#include <cassert>
+#include "DelayCache.h"
+#include "param.h"
+
+// macro body as a string (after expansion)
+#define PARAM_STR2(x) #x
+#define PARAM_STR(x) PARAM_STR2(x)
+
+DelayCache::DelayCache()
+{
+	pthread_mutex_init(&lock_, NULL);
+}
+
+DelayCache::~DelayCache()
+{
+	clear();
+	pthread_mutex_destroy(&lock_);
+}
+
+// static method
+DelayCache& DelayCache::global()
+{
+	static DelayCache cache;
+	return cache;
+}
+
+// static method
+unsigned DelayCache::paramHash()
+{
+	// all delay and load parameters, as written in param.h
+	static const char* params[] = {
+		PARAM_STR(USE_FANOUT_DELAY),
+		PARAM_STR(DELAY_INV), PARAM_STR(LOAD_INV),
+		PARAM_STR(DELAY_AND(n)), PARAM_STR(DELAY_NAND(n)),
+		PARAM_STR(DELAY_OR(n)),  PARAM_STR(DELAY_NOR(n)),
+		PARAM_STR(DELAY_XOR(n)), PARAM_STR(DELAY_XNOR(n)),
+		PARAM_STR(LOAD_AND), PARAM_STR(LOAD_NAND),
+		PARAM_STR(LOAD_OR),  PARAM_STR(LOAD_NOR),
+		PARAM_STR(LOAD_XOR), PARAM_STR(LOAD_XNOR),
+		PARAM_STR(LATCH_CLK2Q), PARAM_STR(REG_CLK2Q),
+	};
+
+	// FNV-1a
+	unsigned h = 2166136261u;
+	for (size_t k = 0; k < sizeof(params)/sizeof(params[0]); k++)
+	{
+		for (const char* c = params[k]; *c; c++)
+			h = (h ^ (unsigned char)*c) * 16777619u;
+		h = (h ^ ';') * 16777619u;
+	}
+	return h;
+}
+
+const DelayCache::DELAYTBL_T* DelayCache::find(const std::string& classname)
+{
+	pthread_mutex_lock(&lock_);
+	DMAPITER_T iter = tables_.find(classname);
+	const DELAYTBL_T* dtbl = (iter == tables_.end()) ? NULL : (*iter).second;
+	pthread_mutex_unlock(&lock_);
+	return dtbl;
+}
+
+const DelayCache::DELAYTBL_T* DelayCache::add(const std::string& classname, DELAYTBL_T* dtbl)
+{
+	assert(dtbl);
+	pthread_mutex_lock(&lock_);
+	DELAYTBL_T*& slot = tables_[classname];
+	if (slot == NULL)
+	{
+		slot = dtbl;
+		if (!path_.empty()) append(classname, *dtbl);
+	}
+	else if (slot != dtbl)
+	{
+		// another thread generated the same table first
+		delete dtbl;
+	}
+	const DELAYTBL_T* result = slot;
+	pthread_mutex_unlock(&lock_);
+	return result;
+}
+
+void DelayCache::clear()
+{
+	pthread_mutex_lock(&lock_);
+	for (DMAPITER_T iter = tables_.begin(); iter != tables_.end(); iter++)
+		delete (*iter).second;
+	tables_.clear();
+	pthread_mutex_unlock(&lock_);
+}
+
+int DelayCache::size()
+{
+	pthread_mutex_lock(&lock_);
+	int N = tables_.size();
+	pthread_mutex_unlock(&lock_);
+	return N;
+}
+
+// File format (text):
+//   elsim-delays <paramHash>
+//   then for each table, a line with the classname, and a line with
+//   the number of entries followed by (input output delay) for each one
+
+void DelayCache::useFile(const std::string& path)
+{
+	pthread_mutex_lock(&lock_);
+	path_ = path;
+	std::set<std::string> saved;
+	if (!load(saved))
+	{
+		// start over (new file, or other parameters)
+		std::ofstream out(path_.c_str(), std::ios::trunc);
+		out << "elsim-delays " << paramHash() << "\n";
+	}
+	// save the tables we already had
+	for (DMAPITER_T iter = tables_.begin(); iter != tables_.end(); iter++)
+		if (!saved.count((*iter).first))
+			append((*iter).first, *(*iter).second);
+	pthread_mutex_unlock(&lock_);
+}
+
+bool DelayCache::load(std::set<std::string>& saved)
+{
+	std::ifstream in(path_.c_str());
+	std::string magic;
+	unsigned hash;
+	if (!(in >> magic >> hash) || magic != "elsim-delays" || hash != paramHash())
+		return false;
+	in.ignore(1);
+
+	std::string classname;
+	while (std::getline(in, classname))
+	{
+		int N;
+		if (!(in >> N) || N < 0) break;
+		DELAYTBL_T* dtbl = new DELAYTBL_T();
+		bool ok = true;
+		for (int k = 0; k < N && ok; k++)
+		{
+			int inum, onum;
+			delay_t T;
+			ok = !(in >> inum >> onum >> T).fail();
+			if (ok) (*dtbl)[IOPAIR_T(inum,onum)] = T;
+		}
+		in.ignore(1);
+		// a truncated table (from an interrupted run) is dropped
+		if (!ok)
+		{
+			delete dtbl;
+			break;
+		}
+
+		// tables we already have are kept (they may be in use)
+		saved.insert(classname);
+		DELAYTBL_T*& slot = tables_[classname];
+		if (slot == NULL) slot = dtbl;
+		else delete dtbl;
+	}
+	return true;
+}
+
+void DelayCache::append(const std::string& classname, const DELAYTBL_T& dtbl)
+{
+	// write the whole entry at once, so concurrent runs don't interleave lines
+	std::ostringstream ss;
+	ss << classname << "\n" << dtbl.size();
+	for (DELAYTBL_T::const_iterator iter = dtbl.begin(); iter != dtbl.end(); iter++)
+		ss << " " << (*iter).first.first << " " << (*iter).first.second << " " << (*iter).second;
+	ss << "\n";
+
+	std::ofstream out(path_.c_str(), std::ios::app);
+	out << ss.str();
+}
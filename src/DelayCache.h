@@ -0,0 +1,68 @@
+#ifndef DELAYCACHE_H_
+#define DELAYCACHE_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <pthread.h>
+#include "BitHistory.h"
+
+// Cache of the delay tables of SystemModule types.
+// A table only depends on the structure of the module type (named by its
+// classname) and on the parameters in "param.h", so tables are shared by all
+// threads and contexts and kept until the program exits (or clear()).
+//
+// With useFile(path), the cache is also kept in a file: tables in the file are
+// loaded at once, and new tables are appended as they are generated, so other
+// runs of the program don't generate them again. The file starts with a hash
+// of the parameters, and it is started over if the parameters have changed.
+class DelayCache
+{
+public:
+	// delay table (maps (input,output) to delay)
+	typedef std::pair<int,int> IOPAIR_T;
+	typedef std::map<IOPAIR_T,delay_t> DELAYTBL_T;
+
+private:
+	typedef std::map<std::string,DELAYTBL_T*> DELAYMAP_T;
+	typedef DELAYMAP_T::iterator DMAPITER_T;
+	DELAYMAP_T tables_;
+	// cache file ("" if none)
+	std::string path_;
+	pthread_mutex_t lock_;
+
+	// read tables from the file, and the names of the tables in it
+	// (false if there is no file or it has other parameters)
+	bool load(std::set<std::string>& saved);
+	// append one table to the file
+	void append(const std::string& classname, const DELAYTBL_T& dtbl);
+
+	DelayCache(const DelayCache&);
+	DelayCache& operator=(const DelayCache&);
+
+public:
+	DelayCache();
+	~DelayCache();
+
+	// the cache used by SystemModule::delay()
+	static DelayCache& global();
+
+	// hash of the parameters that delays depend on
+	static unsigned paramHash();
+
+	// get the table of a module type (NULL if there is none)
+	const DELAYTBL_T* find(const std::string& classname);
+	// add a table and return the cached one
+	// (the cache owns dtbl; if there is already a table, dtbl is deleted)
+	const DELAYTBL_T* add(const std::string& classname, DELAYTBL_T* dtbl);
+
+	// keep the cache in a file (and load the tables that are in it)
+	void useFile(const std::string& path);
+	// delete all tables (must not be used by a simulation or criticalPath())
+	void clear();
+	// number of tables
+	int size();
+};
+
+#endif // DELAYCACHE_H_
@@ -13,7 +13,7 @@ class FA : public Module
 public:
 	FA()
 	{
-		classname_ = "FA";
+		setClassname("FA");
 
 		addInput("X");
 		addInput("Y");
@@ -34,6 +34,26 @@ public:
 		OUT(1) <= ((x & y) | (x & c) | (y & c));
 	}
 
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+	{
+		Bit x = in[0], y = in[1], c = in[2];
+		out[0] = (x ^ y ^ c);
+		out[1] = ((x & y) | (x & c) | (y & c));
+		return true;
+	}
+
+	void evaluate64(const Bit64* in, Bit64* out) const
+	{
+		Bit64 x = in[0], y = in[1], c = in[2];
+		out[0] = (x ^ y ^ c);
+		out[1] = ((x & y) | (x & c) | (y & c));
+	}
+
+	bool hasEvaluate() const
+	{
+		return true;
+	}
+
 	delay_t delay(int inum, int onum)
 	{
 		if (onum == 0)		// all fan-in 2, except OR
@@ -18,7 +18,7 @@ private:
 public:
 	FullAdder() : Adder(1)
 	{
-		classname_ = "FullAdder";
+		setClassname("FullAdder");
 		submodules(3, &orC, &ha0, &ha1);
 
 		IN("X") >> ha0("X");
@@ -10,6 +10,10 @@
 
 class GAP : public Module
 {
+private:
+	InPort X_, Y_;
+	OutPort g_, a_, p_;
+
 public:
 	GAP(int N)
 	{
@@ -20,18 +24,54 @@ public:
 		addOutput("a", N);
 		addOutput("p", N);
 
+		X_ = inPort("X");
+		Y_ = inPort("Y");
+		g_ = outPort("g");
+		a_ = outPort("a");
+		p_ = outPort("p");
+
 		std::stringstream ss;
 		ss << "GAP<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 	}
 
 	void propagate()
 	{
-		BitVector X = IN("X");
-		BitVector Y = IN("Y");
-		OUT("g") <= (X & Y);
-		OUT("a") <= (X | Y);
-		OUT("p") <= (X ^ Y);
+		BitVector X = IN(X_);
+		BitVector Y = IN(Y_);
+		OUT(g_) <= (X & Y);
+		OUT(a_) <= (X | Y);
+		OUT(p_) <= (X ^ Y);
+	}
+
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+	{
+		int N = numInputs() / 2;
+		for (int i = 0; i < N; i++)
+		{
+			Bit x = in[i], y = in[N+i];
+			out[i]     = (x & y);
+			out[N+i]   = (x | y);
+			out[2*N+i] = (x ^ y);
+		}
+		return true;
+	}
+
+	void evaluate64(const Bit64* in, Bit64* out) const
+	{
+		int N = numInputs() / 2;
+		for (int i = 0; i < N; i++)
+		{
+			Bit64 x = in[i], y = in[N+i];
+			out[i]     = (x & y);
+			out[N+i]   = (x | y);
+			out[2*N+i] = (x ^ y);
+		}
+	}
+
+	bool hasEvaluate() const
+	{
+		return true;
 	}
 
 	delay_t delay(int inum, int onum)
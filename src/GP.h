@@ -14,6 +14,10 @@
 
 class GP : public Module
 {
+private:
+	InPort g_, gPrev_, p_, pPrev_;
+	OutPort G_, P_;
+
 public:
 	GP()
 	{
@@ -25,17 +29,44 @@ public:
 		addOutput("G");
 		addOutput("P");
 
-		classname_ = "GP";
+		g_ = inPort("g");
+		gPrev_ = inPort("gPrev");
+		p_ = inPort("p");
+		pPrev_ = inPort("pPrev");
+		G_ = outPort("G");
+		P_ = outPort("P");
+
+		setClassname("GP");
 	}
 
 	void propagate()
 	{
-		Bit g = IN("g");
-		Bit p = IN("p");
-		Bit gPrev = IN("gPrev");
-		Bit pPrev = IN("pPrev");
-		OUT("G") <= (g | (p & gPrev));
-		OUT("P") <= (p & pPrev);
+		Bit g = IN(g_);
+		Bit p = IN(p_);
+		Bit gPrev = IN(gPrev_);
+		Bit pPrev = IN(pPrev_);
+		OUT(G_) <= (g | (p & gPrev));
+		OUT(P_) <= (p & pPrev);
+	}
+
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+	{
+		Bit g = in[0], gPrev = in[1], p = in[2], pPrev = in[3];
+		out[0] = (g | (p & gPrev));
+		out[1] = (p & pPrev);
+		return true;
+	}
+
+	void evaluate64(const Bit64* in, Bit64* out) const
+	{
+		Bit64 g = in[0], gPrev = in[1], p = in[2], pPrev = in[3];
+		out[0] = (g | (p & gPrev));
+		out[1] = (p & pPrev);
+	}
+
+	bool hasEvaluate() const
+	{
+		return true;
 	}
 
 	delay_t delay(int inum, int onum)
@@ -18,12 +18,12 @@ public:                                   \
 		addInputs(Nin);                   \
 		addOutputs(1);                    \
 		if (Nin == 2)                     \
-			classname_ = #OP;             \
+			setClassname(#OP);            \
 		else                              \
 		{                                 \
 			std::stringstream ss;         \
 			ss << #OP "<" << Nin << ">";  \
-			classname_ = ss.str();        \
+			setClassname(ss.str());       \
 		}                                 \
 	}                                     \
 	void propagate()                      \
@@ -37,6 +37,27 @@ public:                                   \
 		}                                 \
 		OUT(0) <= z;                      \
 	}                                     \
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const \
+	{                                     \
+		int Nin = numInputs();            \
+		Bit z = in[0];                    \
+		for (int i = 1; i < Nin; i++)     \
+			z.OP(in[i]);                  \
+		out[0] = z;                       \
+		return true;                      \
+	}                                     \
+	void evaluate64(const Bit64* in, Bit64* out) const \
+	{                                     \
+		int Nin = numInputs();            \
+		Bit64 z = in[0];                  \
+		for (int i = 1; i < Nin; i++)     \
+			z.OP(in[i]);                  \
+		out[0] = z;                       \
+	}                                     \
+	bool hasEvaluate() const              \
+	{                                     \
+		return true;                      \
+	}                                     \
 	delay_t delay(int inum, int onum)     \
 	{                                     \
 		return DELAY_##OP(numInputs());   \
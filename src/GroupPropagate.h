@@ -11,6 +11,10 @@
 
 class GroupPropagate : public Module
 {
+private:
+	InPort X_, Y_;
+	OutPort P_;
+
 public:
 	GroupPropagate(int N)
 	{
@@ -19,9 +23,13 @@ public:
 
 		addOutput("P");
 
+		X_ = inPort("X");
+		Y_ = inPort("Y");
+		P_ = outPort("P");
+
 		std::stringstream ss;
 		ss << "GroupPropagate<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 	}
 
 	void propagate()
@@ -31,12 +39,36 @@ public:
 
 		for (int i = 0; i < N; i++)
 		{
-			Bit x = IN("X",i);
-			Bit y = IN("Y",i);
+			Bit x = IN(X_,i);
+			Bit y = IN(Y_,i);
 			p.AND(x ^ y);
 		}
 
-		OUT("P") <= p;
+		OUT(P_) <= p;
+	}
+
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+	{
+		Bit p(HIGH);
+		int N = numInputs() / 2;
+		for (int i = 0; i < N; i++)
+			p.AND(in[i] ^ in[N+i]);
+		out[0] = p;
+		return true;
+	}
+
+	void evaluate64(const Bit64* in, Bit64* out) const
+	{
+		Bit64 p(HIGH);
+		int N = numInputs() / 2;
+		for (int i = 0; i < N; i++)
+			p.AND(in[i] ^ in[N+i]);
+		out[0] = p;
+	}
+
+	bool hasEvaluate() const
+	{
+		return true;
 	}
 
 	delay_t delay(int inum, int onum)
@@ -10,25 +10,52 @@
 
 class HA : public Module
 {
+private:
+	InPort X_, Y_;
+	OutPort S_, C_;
+
 public:
 	HA()
 	{
-		classname_ = "HA";
+		setClassname("HA");
 
 		addInput("X");
 		addInput("Y");
 
 		addOutput("S");
 		addOutput("C");
+
+		X_ = inPort("X");
+		Y_ = inPort("Y");
+		S_ = outPort("S");
+		C_ = outPort("C");
 	}
 
 	void propagate()
 	{
-		Bit x = IN("X");
-		Bit y = IN("Y");
+		Bit x = IN(X_);
+		Bit y = IN(Y_);
+
+		OUT(S_) <= (x ^ y);
+		OUT(C_) <= (x & y);
+	}
 
-		OUT("S") <= (x ^ y);
-		OUT("C") <= (x & y);
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+	{
+		out[0] = (in[0] ^ in[1]);
+		out[1] = (in[0] & in[1]);
+		return true;
+	}
+
+	void evaluate64(const Bit64* in, Bit64* out) const
+	{
+		out[0] = (in[0] ^ in[1]);
+		out[1] = (in[0] & in[1]);
+	}
+
+	bool hasEvaluate() const
+	{
+		return true;
 	}
 
 	delay_t delay(int inum, int onum)
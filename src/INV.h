@@ -10,21 +10,48 @@
 
 class INV : public Module
 {
+private:
+	InPort X_;
+	OutPort Z_;
+
 public:
 	INV(int N)
 	{
 		addInput("X", N);
 		addOutput("Z", N);
 
+		X_ = inPort("X");
+		Z_ = outPort("Z");
+
 		std::stringstream ss;
 		ss << "INV<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 	}
 
 	void propagate()
 	{
-		BitVector vec = IN("X");
-		OUT("Z") <= vec.NOT();
+		BitVector vec = IN(X_);
+		OUT(Z_) <= vec.NOT();
+	}
+
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+	{
+		int N = numOutputs();
+		for (int i = 0; i < N; i++)
+			out[i] = ~in[i];
+		return true;
+	}
+
+	void evaluate64(const Bit64* in, Bit64* out) const
+	{
+		int N = numOutputs();
+		for (int i = 0; i < N; i++)
+			out[i] = ~in[i];
+	}
+
+	bool hasEvaluate() const
+	{
+		return true;
 	}
 
 	delay_t delay(int inum, int onum)
@@ -55,20 +82,47 @@ public:
 
 class BUF : public Module
 {
+private:
+	InPort X_;
+	OutPort Z_;
+
 public:
 	BUF(int N)
 	{
 		addInput("X", N);
 		addOutput("Z", N);
 
+		X_ = inPort("X");
+		Z_ = outPort("Z");
+
 		std::stringstream ss;
 		ss << "BUF<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 	}
 
 	void propagate()
 	{
-		OUT("Z") <= IN("X");
+		OUT(Z_) <= IN(X_);
+	}
+
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+	{
+		int N = numOutputs();
+		for (int i = 0; i < N; i++)
+			out[i] = in[i];
+		return true;
+	}
+
+	void evaluate64(const Bit64* in, Bit64* out) const
+	{
+		int N = numOutputs();
+		for (int i = 0; i < N; i++)
+			out[i] = in[i];
+	}
+
+	bool hasEvaluate() const
+	{
+		return true;
 	}
 
 	delay_t delay(int inum, int onum)
@@ -0,0 +1,305 @@
+#include <cstring>
+#include <time.h>
+#include <vector>
+#include "Kernels.h"
+
+// The kernels are written once for a generic word type V (uint64_t, or a
+// GCC vector of 2, 4 or 8 uint64_t), and compiled for each instruction set
+// with a target attribute. Each value is a pair of planes (see Bit64).
+
+template<class V>
+struct Tri
+{
+	V val;
+	V def;
+};
+
+#define KINLINE inline __attribute__((always_inline))
+
+// a LOW input forces AND to LOW, a HIGH input forces OR to HIGH
+struct OpAND
+{
+	template<class V> static KINLINE void op(const Tri<V>& x, const Tri<V>& y, Tri<V>& z)
+	{
+		V h = x.val & y.val;
+		z.def = h | (x.def & ~x.val) | (y.def & ~y.val);
+		z.val = h;
+	}
+};
+
+struct OpOR
+{
+	template<class V> static KINLINE void op(const Tri<V>& x, const Tri<V>& y, Tri<V>& z)
+	{
+		V h = x.val | y.val;
+		z.def = h | ((x.def & ~x.val) & (y.def & ~y.val));
+		z.val = h;
+	}
+};
+
+struct OpXOR
+{
+	template<class V> static KINLINE void op(const Tri<V>& x, const Tri<V>& y, Tri<V>& z)
+	{
+		z.def = x.def & y.def;
+		z.val = (x.val ^ y.val) & z.def;
+	}
+};
+
+struct OpNOT
+{
+	template<class V> static KINLINE void op(const Tri<V>& x, Tri<V>& z)
+	{
+		z.val = ~x.val & x.def;
+		z.def = x.def;
+	}
+};
+
+// a gate that inverts the output of another
+template<class OP>
+struct OpInverted
+{
+	template<class V> static KINLINE void op(const Tri<V>& x, const Tri<V>& y, Tri<V>& z)
+	{
+		Tri<V> t;
+		OP::op(x, y, t);
+		OpNOT::op(t, z);
+	}
+};
+
+// modules (same order of inputs/outputs as the Module)
+
+template<class OP>
+struct Mod2to1
+{
+	enum { NIN = 2, NOUT = 1 };
+	template<class V> static KINLINE void eval(const Tri<V>* in, Tri<V>* out)
+	{
+		OP::op(in[0], in[1], out[0]);
+	}
+};
+
+struct ModINV
+{
+	enum { NIN = 1, NOUT = 1 };
+	template<class V> static KINLINE void eval(const Tri<V>* in, Tri<V>* out)
+	{
+		OpNOT::op(in[0], out[0]);
+	}
+};
+
+struct ModBUF
+{
+	enum { NIN = 1, NOUT = 1 };
+	template<class V> static KINLINE void eval(const Tri<V>* in, Tri<V>* out)
+	{
+		out[0] = in[0];
+	}
+};
+
+struct ModMUX
+{
+	enum { NIN = 3, NOUT = 1 };
+	template<class V> static KINLINE void eval(const Tri<V>* in, Tri<V>* out)
+	{
+		V l = in[2].def & ~in[2].val;
+		V h = in[2].val;
+		out[0].val = (l & in[0].val) | (h & in[1].val);
+		out[0].def = (l & in[0].def) | (h & in[1].def);
+	}
+};
+
+struct ModFA
+{
+	enum { NIN = 3, NOUT = 2 };
+	template<class V> static KINLINE void eval(const Tri<V>* in, Tri<V>* out)
+	{
+		Tri<V> t, xy, xc, yc;
+		OpXOR::op(in[0], in[1], t);
+		OpXOR::op(t, in[2], out[0]);
+		OpAND::op(in[0], in[1], xy);
+		OpAND::op(in[0], in[2], xc);
+		OpAND::op(in[1], in[2], yc);
+		OpOR::op(xy, xc, t);
+		OpOR::op(t, yc, out[1]);
+	}
+};
+
+struct ModHA
+{
+	enum { NIN = 2, NOUT = 2 };
+	template<class V> static KINLINE void eval(const Tri<V>* in, Tri<V>* out)
+	{
+		OpXOR::op(in[0], in[1], out[0]);
+		OpAND::op(in[0], in[1], out[1]);
+	}
+};
+
+struct ModGP
+{
+	enum { NIN = 4, NOUT = 2 };
+	template<class V> static KINLINE void eval(const Tri<V>* in, Tri<V>* out)
+	{
+		Tri<V> t;
+		OpAND::op(in[2], in[1], t);
+		OpOR::op(in[0], t, out[0]);
+		OpAND::op(in[2], in[3], out[1]);
+	}
+};
+
+struct ModGAP
+{
+	enum { NIN = 2, NOUT = 3 };
+	template<class V> static KINLINE void eval(const Tri<V>* in, Tri<V>* out)
+	{
+		OpAND::op(in[0], in[1], out[0]);
+		OpOR::op(in[0], in[1], out[1]);
+		OpXOR::op(in[0], in[1], out[2]);
+	}
+};
+
+// evaluate `count` words starting at word w with word type V
+template<class V, class MOD>
+static KINLINE void evalWords(int w, const Lanes* in, const Lanes* out)
+{
+	Tri<V> x[MOD::NIN], z[MOD::NOUT];
+	for (int i = 0; i < MOD::NIN; i++)
+	{
+		memcpy(&x[i].val, in[i].val + w, sizeof(V));
+		memcpy(&x[i].def, in[i].def + w, sizeof(V));
+	}
+	MOD::eval(x, z);
+	for (int o = 0; o < MOD::NOUT; o++)
+	{
+		memcpy(out[o].val + w, &z[o].val, sizeof(V));
+		memcpy(out[o].def + w, &z[o].def, sizeof(V));
+	}
+}
+
+// whole vectors, then single words
+template<class V, class MOD>
+static KINLINE void kernel(int N, const Lanes* in, const Lanes* out)
+{
+	const int L = sizeof(V) / sizeof(uint64_t);
+	int w = 0;
+	for (; w + L <= N; w += L)
+		evalWords<V,MOD>(w, in, out);
+	for (; w < N; w++)
+		evalWords<uint64_t,MOD>(w, in, out);
+}
+
+// all kernels for one instruction set
+#define DEFINE_KERNELS(ISA, V, TARGET)                                                                          \
+TARGET static void ISA##_AND (int N, const Lanes* in, const Lanes* out) { kernel<V,Mod2to1<OpAND> >(N, in, out); } \
+TARGET static void ISA##_OR  (int N, const Lanes* in, const Lanes* out) { kernel<V,Mod2to1<OpOR> >(N, in, out); }  \
+TARGET static void ISA##_XOR (int N, const Lanes* in, const Lanes* out) { kernel<V,Mod2to1<OpXOR> >(N, in, out); } \
+TARGET static void ISA##_NAND(int N, const Lanes* in, const Lanes* out) { kernel<V,Mod2to1<OpInverted<OpAND> > >(N, in, out); } \
+TARGET static void ISA##_NOR (int N, const Lanes* in, const Lanes* out) { kernel<V,Mod2to1<OpInverted<OpOR> > >(N, in, out); }  \
+TARGET static void ISA##_XNOR(int N, const Lanes* in, const Lanes* out) { kernel<V,Mod2to1<OpInverted<OpXOR> > >(N, in, out); } \
+TARGET static void ISA##_INV (int N, const Lanes* in, const Lanes* out) { kernel<V,ModINV>(N, in, out); }  \
+TARGET static void ISA##_BUF (int N, const Lanes* in, const Lanes* out) { kernel<V,ModBUF>(N, in, out); }  \
+TARGET static void ISA##_MUX (int N, const Lanes* in, const Lanes* out) { kernel<V,ModMUX>(N, in, out); }  \
+TARGET static void ISA##_FA  (int N, const Lanes* in, const Lanes* out) { kernel<V,ModFA>(N, in, out); }   \
+TARGET static void ISA##_HA  (int N, const Lanes* in, const Lanes* out) { kernel<V,ModHA>(N, in, out); }   \
+TARGET static void ISA##_GP  (int N, const Lanes* in, const Lanes* out) { kernel<V,ModGP>(N, in, out); }   \
+TARGET static void ISA##_GAP (int N, const Lanes* in, const Lanes* out) { kernel<V,ModGAP>(N, in, out); }  \
+static const GateKernels ISA##_kernels = {                                                                  \
+	#ISA, (int)(64 * sizeof(V) / sizeof(uint64_t)),                                                         \
+	ISA##_AND, ISA##_OR, ISA##_XOR, ISA##_NAND, ISA##_NOR, ISA##_XNOR,                                      \
+	ISA##_INV, ISA##_BUF, ISA##_MUX, ISA##_FA, ISA##_HA, ISA##_GP, ISA##_GAP                                \
+};
+
+DEFINE_KERNELS(scalar, uint64_t, )
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_SIMD_KERNELS 1
+typedef uint64_t V128 __attribute__((vector_size(16)));
+typedef uint64_t V256 __attribute__((vector_size(32)));
+typedef uint64_t V512 __attribute__((vector_size(64)));
+DEFINE_KERNELS(sse2, V128, __attribute__((target("sse2"))))
+DEFINE_KERNELS(avx2, V256, __attribute__((target("avx2"))))
+DEFINE_KERNELS(avx512, V512, __attribute__((target("avx512f"))))
+#endif
+
+// supported kernels, from narrowest to widest
+static std::vector<const GateKernels*> findKernels()
+{
+	std::vector<const GateKernels*> found;
+	found.push_back(&scalar_kernels);
+#ifdef HAVE_SIMD_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))    found.push_back(&sse2_kernels);
+	if (__builtin_cpu_supports("avx2"))    found.push_back(&avx2_kernels);
+	if (__builtin_cpu_supports("avx512f")) found.push_back(&avx512_kernels);
+#endif
+	return found;
+}
+
+// found on first use (so they can be used from static initializers too)
+static const std::vector<const GateKernels*>& supportedKernels()
+{
+	static const std::vector<const GateKernels*> found = findKernels();
+	return found;
+}
+
+// seconds for a batch of full adders (the best of a few tries)
+static double timeKernels(const GateKernels& kern)
+{
+	const int N = 256;
+	std::vector<uint64_t> planes(10*N, 0);
+	Lanes in[3], out[2];
+	for (int i = 0; i < 3; i++) in[i] = Lanes(&planes[2*i*N], &planes[(2*i+1)*N]);
+	for (int o = 0; o < 2; o++) out[o] = Lanes(&planes[(6+2*o)*N], &planes[(7+2*o)*N]);
+
+	double best = 0;
+	for (int t = 0; t < 5; t++)
+	{
+		struct timespec t0, t1;
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (int r = 0; r < 64; r++)
+			kern.FA(N, in, out);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		double T = (t1.tv_sec - t0.tv_sec) + 1e-9*(t1.tv_nsec - t0.tv_nsec);
+		if (t == 0 || T < best) best = T;
+	}
+	return best;
+}
+
+// the fastest supported kernels, measured on this CPU
+// (wider vectors aren't always faster: some CPUs slow down for AVX-512,
+// so a wider set must be clearly faster to be chosen)
+static const GateKernels* fastestKernels()
+{
+	const std::vector<const GateKernels*>& found = supportedKernels();
+	const GateKernels* fastest = found[0];
+	double Tmin = timeKernels(*fastest);
+	for (size_t k = 1; k < found.size(); k++)
+	{
+		double T = timeKernels(*found[k]);
+		if (T < 0.9 * Tmin)
+		{
+			fastest = found[k];
+			Tmin = T;
+		}
+	}
+	return fastest;
+}
+
+// static method
+const GateKernels& GateKernels::best()
+{
+	static const GateKernels* fastest = fastestKernels();
+	return *fastest;
+}
+
+// static method
+int GateKernels::numSupported()
+{
+	return supportedKernels().size();
+}
+
+// static method
+const GateKernels& GateKernels::supported(int k)
+{
+	return *supportedKernels().at(k);
+}
@@ -0,0 +1,54 @@
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+#include <cstddef>
+#include <stdint.h>
+
+// Packed 3-state lanes in two planes (same encoding as Bit64):
+// lane j of word w is defined if bit j of def[w] is set, and its value is
+// bit j of val[w] (always 0 if the lane is undefined).
+struct Lanes
+{
+	uint64_t* val;
+	uint64_t* def;
+	Lanes(uint64_t* v=NULL, uint64_t* d=NULL) : val(v), def(d) {}
+};
+
+// compute N words of every output from N words of every input
+// (outputs may be the same arrays as inputs)
+typedef void (*KERNEL_T)(int N, const Lanes* in, const Lanes* out);
+
+// Batched gate evaluation kernels for one instruction set.
+// Every kernel works like the evaluate64() of the same module on each lane.
+// Use GateKernels::best() for the fastest kernels this CPU supports
+// (measured on first use), or supported(k) to compare them.
+struct GateKernels
+{
+	// instruction set name ("scalar", "sse2", "avx2", "avx512")
+	const char* isa;
+	// lanes per instruction
+	int width;
+
+	// in: X,Y           out: Z
+	KERNEL_T AND, OR, XOR, NAND, NOR, XNOR;
+	// in: X             out: Z
+	KERNEL_T INV, BUF;
+	// in: X,Y,S         out: Z (X where S is LOW, Y where S is HIGH)
+	KERNEL_T MUX;
+	// in: X,Y,Ci        out: S,Co
+	KERNEL_T FA;
+	// in: X,Y           out: S,Co
+	KERNEL_T HA;
+	// in: G,Gprev,P,Pprev  out: G,P
+	KERNEL_T GP;
+	// in: X,Y           out: g,a,p
+	KERNEL_T GAP;
+
+	// the fastest kernels supported by this CPU
+	static const GateKernels& best();
+	// all kernels supported by this CPU (0 is scalar, then wider vectors)
+	static int numSupported();
+	static const GateKernels& supported(int k);
+};
+
+#endif // KERNELS_H_
@@ -11,12 +11,14 @@ class MultipleGenerator : public Module
 		int x_width_;
 		int mth_pp_;
 		int sim_calls_;
+		InPort X_, sign_, one_, two_;
+		OutPort pp_;
 	public: 
 		MultipleGenerator(int N, int m) // N-bit multiplicand, mth partial product
 		{
 			std::stringstream ss;
 			ss << "MultipleGenerator<" << m << ">";
-			classname_ = ss.str();
+			setClassname(ss.str());
 			x_width_ = N;
 			mth_pp_ = m;
 			sim_calls_ = 0;
@@ -27,15 +29,22 @@ class MultipleGenerator : public Module
 
 			addOutput("pp", 2*N); // partial product
 
+			X_ = inPort("X");
+			sign_ = inPort("sign");
+			one_ = inPort("one");
+			two_ = inPort("two");
+			pp_ = outPort("pp");
 		}
 
 		void propagate()
 		{
 			sim_calls_++;
-			std::cout << "simulated " << sim_calls_ << " times for " << classname_ << std::endl;
-			Bit sign = IN("sign");
-			Bit one = IN("one");
-			Bit two = IN("two");
+#ifdef DEBUG
+			std::cout << "simulated " << sim_calls_ << " times for " << classname() << std::endl;
+#endif
+			Bit sign = IN(sign_);
+			Bit one = IN(one_);
+			Bit two = IN(two_);
 			BitVector X(2*x_width_,0);
 			BitVector Xshifted(2*x_width_,0);
 			// BitVector NotX(2*x_width_,0);
@@ -43,7 +52,7 @@ class MultipleGenerator : public Module
 			int j = 0;
 			for (int i = mth_pp_*2; i < mth_pp_*2+x_width_; i++)
 			{
-				Bit n = IN("X",j);
+				Bit n = IN(X_,j);
 				// std::cout << n;
 				X.set(i, n);
 				Xshifted.set(i+1, n);
@@ -72,23 +81,23 @@ class MultipleGenerator : public Module
 			if (one.bit == 1 && sign.bit == 0)
 			{
 				// std::cout <<"same" << std::endl;
-				OUT("pp") <= X;
+				OUT(pp_) <= X;
 			}
 			else if(one.bit == 1 && sign.bit == 1)
 			{
-				OUT("pp") <= NotX;
+				OUT(pp_) <= NotX;
 			}
 			else if(two.bit == 1 && sign.bit == 0)
 			{
-				OUT("pp") <= Xshifted;
+				OUT(pp_) <= Xshifted;
 			}
 			else if (two.bit == 1 && sign.bit == 1)
 			{
-				OUT("pp") <= NotXshifted;
+				OUT(pp_) <= NotXshifted;
 			}
 			else
 			{
-				OUT("pp") <= 0;
+				OUT(pp_) <= 0;
 			}
 			// unsigned int x = 0;
 			// for (int i = x_width_-1; i >= 0; i--)
@@ -136,7 +145,53 @@ class MultipleGenerator : public Module
 			// 		OUT("pp", i) <= Bit(0);
 			// 	}
 			// }
-			std::cout << "partial product: " << OUT("pp") << std::endl;
+#ifdef DEBUG
+			std::cout << "partial product: " << OUT(pp_) << std::endl;
+#endif
+		}
+
+		bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+		{
+			Bit sign = in[x_width_];
+			Bit one = in[x_width_+1];
+			Bit two = in[x_width_+2];
+			BitVector X(2*x_width_,0);
+			BitVector Xshifted(2*x_width_,0);
+			int j = 0;
+			for (int i = mth_pp_*2; i < mth_pp_*2+x_width_; i++)
+			{
+				X.set(i, in[j]);
+				Xshifted.set(i+1, in[j]);
+				j++;
+			}
+
+			BitVector NotX = ~X;
+			BitVector NotXshifted = ~Xshifted;
+
+			for (int i = 0; i < mth_pp_*2; i++)
+			{
+				NotX.set(i,0);
+				NotXshifted.set(i,0);
+			}
+
+			BitVector pp(2*x_width_,0);
+			if (one.bit == 1 && sign.bit == 0)
+				pp = X;
+			else if(one.bit == 1 && sign.bit == 1)
+				pp = NotX;
+			else if(two.bit == 1 && sign.bit == 0)
+				pp = Xshifted;
+			else if (two.bit == 1 && sign.bit == 1)
+				pp = NotXshifted;
+
+			for (int i = 0; i < 2*x_width_; i++)
+				out[i] = pp.get(i);
+			return true;
+		}
+
+		bool hasEvaluate() const
+		{
+			return true;
 		}
 
 		delay_t delay(int inum, int onum)
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include "LevelSim.h"
+#include "Wire.h"
+
+LevelSim::LevelSim(Module& top) :
+	 net_(top)
+	,value_(net_.numNets())
+	,timed_(net_.firstOutput(net_.numCells()), 0)
+	,in_(std::max(net_.maxInputs(),1))
+	,out_(std::max(net_.maxOutputs(),1))
+	,changed_((net_.maxInputs()+63)/64 + 1, ~(uint64_t)0)
+{
+	Nlevels_ = net_.levelize(order_, level_, loops_);
+
+	// outputs with no delay from any input are never set by a timed simulation
+	// (same as NetlistSim::propagate)
+	const Netlist& nl = net_;
+	for (int c = 0; c < nl.numCells(); c++)
+	{
+		std::vector<delay_t> maxdelay(nl.numOutputs(c), DELAY_T_MIN);
+		for (int p = nl.firstInput(c); p < nl.firstInput(c) + nl.numInputs(c); p++)
+		{
+			for (int a = nl.firstArc(p); a < nl.endArc(p); a++)
+			{
+				delay_t& d = maxdelay[nl.arcOutput(a)];
+				if (nl.arcDelay(a) > d) d = nl.arcDelay(a);
+			}
+		}
+		for (int o = 0; o < nl.numOutputs(c); o++)
+		{
+			int q = nl.firstOutput(c) + o;
+			delay_t dT = maxdelay[o];
+#if USE_FANOUT_DELAY
+			if (dT >= 0)
+				dT += nl.outputFanout(q);
+#endif
+			timed_[q] = (dT > 0);
+		}
+	}
+}
+
+void LevelSim::simulate(delay_t T)
+{
+	const Netlist& nl = net_;
+	int N = nl.numNets();
+
+	// current values of the nets (the inputs may have been changed)
+	for (int n = 0; n < N; n++)
+		value_[n] = nl.net(n)->get();
+
+	int C = order_.size();
+	for (int k = 0; k < C; k++)
+	{
+		int c = order_[k];
+		int Nin = nl.numInputs(c);
+		int Nout = nl.numOutputs(c);
+		int p0 = nl.firstInput(c);
+		int q0 = nl.firstOutput(c);
+
+		for (int i = 0; i < Nin; i++)
+		{
+			int n = nl.inputNet(p0+i);
+			in_[i] = (n < 0) ? Bit() : value_[n];
+		}
+
+		if (!nl.cell(c)->evaluate(&in_[0], &changed_[0], &out_[0]))
+			continue;
+
+		for (int o = 0; o < Nout; o++)
+		{
+			if (!timed_[q0+o]) continue;
+			int n = nl.outputNet(q0+o);
+			if (out_[o] == value_[n]) continue;
+			value_[n] = out_[o];
+			nl.net(n)->set(out_[o], T);
+		}
+	}
+}
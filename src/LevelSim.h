@@ -0,0 +1,55 @@
+#ifndef LEVELSIM_H_
+#define LEVELSIM_H_
+
+#include <vector>
+#include "Netlist.h"
+
+// Zero-delay simulation of one input vector (see Module::simUseMode).
+// The module is flattened and its cells are sorted by level once. Then each
+// simulate() evaluates every cell exactly once in level order, with no queue,
+// no history and no delay lookups, and sets the final value of each wire at
+// the given time. For combinational designs, getValue()/getVector() give the
+// same results as a timed simulation (but there are no delays or power stats).
+// Designs with loops can't be simulated this way (see hasLoops()).
+//
+// Like the Netlist, it refers to the original modules and wires.
+class LevelSim
+{
+private:
+	Netlist net_;
+	// cells in level order
+	std::vector<int> order_;
+	std::vector<int> level_;
+	int Nlevels_;
+	bool loops_;
+
+	// value of each net
+	std::vector<Bit> value_;
+	// outputs that a timed simulation can set (they have a delay from some input)
+	std::vector<char> timed_;
+
+	// scratch space for one cell
+	std::vector<Bit> in_;
+	std::vector<Bit> out_;
+	// every input is treated as changed
+	std::vector<uint64_t> changed_;
+
+	LevelSim(const LevelSim&);
+	LevelSim& operator=(const LevelSim&);
+
+public:
+	// flatten and levelize the hierarchy under `top`
+	LevelSim(Module& top);
+
+	// evaluate all cells in level order and set the wires at time T
+	void simulate(delay_t T=0);
+
+	// the flattened module
+	const Netlist& netlist() const { return net_; }
+
+	// levelization info
+	int numLevels() const { return Nlevels_; }
+	bool hasLoops() const { return loops_; }
+};
+
+#endif // LEVELSIM_H_
@@ -125,7 +125,7 @@ public:
 		// generate classname
 		std::stringstream ss;
 		ss << "LookaheadAdder<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		// connect submodules together
 		init();
@@ -158,7 +158,7 @@ public:
 		addOutput("P", 1);
 
 		// copy classname from other
-		classname_ = other.classname_;
+		setClassname(other.classname());
 
 		// add subadders if hierarchical
 		if (hierarchical)
@@ -199,7 +199,7 @@ public:
 		// generate classname
 		std::stringstream ss;
 		ss << "LookaheadAdder<" << N << "," << grpadder.classname() << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		// create and register adders
 		for (int i = 0; i < Ngrp; i++)
@@ -22,7 +22,7 @@ public:
 
 		std::stringstream ss;
 		ss << "LookaheadGenerator<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		// generate N-1 P bits
 		// each is a single AND of fanin 2,3,4,...N
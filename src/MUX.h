@@ -12,6 +12,10 @@
 
 class MUX : public Module
 {
+private:
+	InPort A_, B_, SEL_;
+	OutPort Z_;
+
 public:
 	MUX(int N=1)
 	{
@@ -21,21 +25,55 @@ public:
 
 		addOutput("Z", N);
 
+		A_ = inPort("A");
+		B_ = inPort("B");
+		SEL_ = inPort("SEL");
+		Z_ = outPort("Z");
+
 		std::stringstream ss;
 		ss << "MUX<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 	}
 
 	void propagate()
 	{
-		Bit sel = IN("SEL");
+		Bit sel = IN(SEL_);
 
 		if (sel == LOW)
-			OUT("Z") <= IN("A");
+			OUT(Z_) <= IN(A_);
 		else if (sel == HIGH)
-			OUT("Z") <= IN("B");
+			OUT(Z_) <= IN(B_);
 		else
-			OUT("Z") <= BitVector(numOutputs()); // undefined bits
+			OUT(Z_) <= BitVector(numOutputs()); // undefined bits
+	}
+
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+	{
+		int N = numOutputs();
+		Bit sel = in[2*N];
+		for (int i = 0; i < N; i++)
+		{
+			if (sel == LOW)
+				out[i] = in[i];
+			else if (sel == HIGH)
+				out[i] = in[N+i];
+			else
+				out[i] = Bit(); // undefined bits
+		}
+		return true;
+	}
+
+	void evaluate64(const Bit64* in, Bit64* out) const
+	{
+		int N = numOutputs();
+		Bit64 sel = in[2*N];
+		for (int i = 0; i < N; i++)
+			out[i] = Bit64::mux(sel, in[i], in[N+i]);
+	}
+
+	bool hasEvaluate() const
+	{
+		return true;
 	}
 
 	delay_t delay(int inum, int onum)
@@ -22,7 +22,7 @@ public:
 
 		std::stringstream ss;
 		ss << GATE(Nin).classname() << "<" << Nin << "x" << width << "bit>";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		for (int i = 0; i < Nin; i++)
 		{
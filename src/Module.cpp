@@ -4,7 +4,11 @@
 #include <cstdarg>
 #include "Module.h"
 #include "Wire.h"
-#include "SimQueue.h"
+#include "SimContext.h"
+#include "WorkPool.h"
+#include "LevelSim.h"
+#include "ModuleType.h"
+#include "PowerReport.h"
 #include "param.h"
 
 ////////////////////////////////////////////////////////////
@@ -12,17 +16,22 @@
 ////////////////////////////////////////////////////////////
 
 // defafult constructor
-Module::Module()
+Module::Module() :
+	 type_(ModuleType::empty())
+	,levelSim_(NULL)
+	,levelVersion_(0)
 #ifdef MOD_EXTRA
-	: tag(-1), parent(NULL)
+	,tag(-1)
+	,parent(NULL)
 #endif
 {
 }
 
 // copy constructor
 Module::Module(const Module& other) :
-	 nameMap_(other.nameMap_)
-	,classname_(other.classname_)
+	 type_(other.type_)
+	,levelSim_(NULL)
+	,levelVersion_(0)
 #ifdef MOD_EXTRA
 	,tag(-1)
 	,parent(NULL)
@@ -31,7 +40,7 @@ Module::Module(const Module& other) :
 	int Nin = other.numInputs();
 	int Nout = other.numOutputs();
 #ifdef DEBUG
-std::cout << "copy constructing " << classname_ << " " << &other
+std::cout << "copy constructing " << type_->classname() << " " << &other
           << " " << Nin << "in " << Nout << "out" << std::endl;
 #endif
 
@@ -44,20 +53,20 @@ std::cout << "copy constructing " << classname_ << " " << &other
 
 	for (int i = 0; i < Nout; i++)
 		assert(!other.outWires_[i]);
-
-	// set `module` pointer in `nameMap_` Ports to `this`
-	for (SIGNAMEMAP_T::iterator iter = nameMap_.begin(); iter != nameMap_.end(); iter++)
-		(*iter).second.module = this;
 }
 
 Module::~Module()
 {
+	delete levelSim_;
+
 	WIREITER_T iter;
 	// release input wires
 	for (iter = inWires_.begin(); iter != inWires_.end(); iter++)
 	{
 		Wire* w = *iter;
-		if (w) w->release();
+		if (!w) continue;
+		if (!w->aliases().empty()) w->removeAlias(this, iter - inWires_.begin());
+		w->release();
 	}
 	// release output wires
 	for (iter = outWires_.begin(); iter != outWires_.end(); iter++)
@@ -70,8 +79,13 @@ Module::~Module()
 // get classname
 const std::string& Module::classname() const
 {
-	assert(classname_.length() > 0);
-	return classname_;
+	assert(type_->classname().length() > 0);
+	return type_->classname();
+}
+
+void Module::setClassname(const std::string& name)
+{
+	type_ = type_->withClassname(name);
 }
 
 bool Module::isSystem() const
@@ -94,6 +108,37 @@ energy_t Module::energy(int onum) const
 	return 0; // default implemetnation -- subclasses should override
 }
 
+bool Module::evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+{
+	assert(0); // only defined by subclasses that return true from hasEvaluate()
+	return false;
+}
+
+bool Module::hasEvaluate() const
+{
+	return false; // default implementation -- subclasses may override
+}
+
+void Module::evaluate64(const Bit64* in, Bit64* out) const
+{
+	// default implementation -- one pattern at a time
+	int Nin = numInputs();
+	int Nout = numOutputs();
+	std::vector<Bit> inbits(Nin+1), outbits(Nout+1);
+	std::vector<uint64_t> changed((Nin+63)/64 + 1, ~(uint64_t)0);
+	for (int k = 0; k < 64; k++)
+	{
+		for (int i = 0; i < Nin; i++)
+			inbits[i] = in[i].get(k);
+		for (int o = 0; o < Nout; o++)
+			outbits[o] = out[o].get(k);
+		if (!evaluate(&inbits[0], &changed[0], &outbits[0]))
+			continue;
+		for (int o = 0; o < Nout; o++)
+			out[o].set(k, outbits[o]);
+	}
+}
+
 ////////////////////////////////////////////////////////////
 // Set up input/output signals
 ////////////////////////////////////////////////////////////
@@ -117,9 +162,9 @@ void Module::defineInput(const std::string& name, int high, int low)
 	assert(low >= 0 && high >= low);
 	assert(high < numInputs());
 	assert(name.length() > 0);
-	assert(nameMap_.count(name) == 0);
+	assert(!type_->findPort(name));
 
-	nameMap_.insert(NAMEPAIR_T(name, Port(this,low,high,false)));
+	type_ = type_->withPort(name, PortDef(low,high,false));
 }
 
 void Module::defineInput(const std::string& name, int i)
@@ -132,9 +177,9 @@ void Module::defineOutput(const std::string& name, int high, int low)
 	assert(high >= 0 && low >= 0 && high >= low);
 	assert(high < numOutputs());
 	assert(name.length() > 0);
-	assert(nameMap_.count(name) == 0);
+	assert(!type_->findPort(name));
 
-	nameMap_.insert(NAMEPAIR_T(name, Port(this,low,high,true)));
+	type_ = type_->withPort(name, PortDef(low,high,true));
 }
 
 void Module::defineOutput(const std::string& name, int i)
@@ -162,9 +207,10 @@ Module::NamedPort Module::nameOfInput(int inum) const
 	assert(inum >= 0 && inum < numInputs());
 
 	// lookup this input number in the name map
-	for (NAMEITER_T iter = nameMap_.begin(); iter != nameMap_.end(); iter++)
+	const ModuleType::PORTMAP_T& ports = type_->ports();
+	for (ModuleType::DEFITER_T iter = ports.begin(); iter != ports.end(); iter++)
 	{
-		const Port& p = (*iter).second;
+		const PortDef& p = (*iter).second;
 		if (!p.isOutput && inum >= p.low && inum <= p.high)
 			return NamedPort( (*iter).first , (p.low==p.high) ? -1 : (inum-p.low) , false );
 	}
@@ -177,9 +223,10 @@ Module::NamedPort Module::nameOfOutput(int onum) const
 	assert(onum >= 0 && onum < numOutputs());
 
 	// lookup this output number in the name map
-	for (NAMEITER_T iter = nameMap_.begin(); iter != nameMap_.end(); iter++)
+	const ModuleType::PORTMAP_T& ports = type_->ports();
+	for (ModuleType::DEFITER_T iter = ports.begin(); iter != ports.end(); iter++)
 	{
-		const Port& p = (*iter).second;
+		const PortDef& p = (*iter).second;
 		if (p.isOutput && onum >= p.low && onum <= p.high)
 			return NamedPort( (*iter).first , (p.low==p.high) ? -1 : (onum-p.low) , true );
 	}
@@ -189,16 +236,14 @@ Module::NamedPort Module::nameOfOutput(int onum) const
 
 bool Module::hasInput(const std::string& name) const
 {
-	NAMEITER_T iter = nameMap_.find(name);
-	if (iter == nameMap_.end()) return false;
-	return !(*iter).second.isOutput;
+	const PortDef* p = type_->findPort(name);
+	return p && !p->isOutput;
 }
 
 bool Module::hasOutput(const std::string& name) const
 {
-	NAMEITER_T iter = nameMap_.find(name);
-	if (iter == nameMap_.end()) return false;
-	return (*iter).second.isOutput;
+	const PortDef* p = type_->findPort(name);
+	return p && p->isOutput;
 }
 
 ////////////////////////////////////////////////////////////
@@ -228,6 +273,7 @@ bool Module::setInput(int i, Bit b, delay_t T)
 	{
 		inWires_[i] = w = new Wire();
 		if (!isSystem()) w->addReader(this, i);
+		else w->addAlias(this, i);
 	}
 
 	return w->set(b,T);
@@ -238,6 +284,16 @@ bool Module::setOutput(int i, Bit b, delay_t T)
 	assert(i >= 0 && i < numOutputs());
 	Wire* w = outWires_[i];
 
+	// during a parallel step, outputs are set after all modules are propagated
+	// (they must be set after the current time, or other modules could read them)
+	SimContext& ctx = SimContext::current();
+	if (ctx.writes_)
+	{
+		assert(T > ctx.time_);
+		ctx.writes_->push_back(SimWrite(this, i, b, T));
+		return true;
+	}
+
 	if (w == NULL)
 	{
 		outWires_[i] = w = new Wire();
@@ -246,9 +302,28 @@ bool Module::setOutput(int i, Bit b, delay_t T)
 
 	// IMPORTANT FOR SIMULATION
 	// during simulation we must call wireDidChange() callback
+	int edges = w->numEdges();
 	bool changed = w->set(b,T);
-	if (changed && simqueue)
-		wireDidChange(w,T);
+	if (changed)
+	{
+		if (ctx.queue_)
+		{
+			// every new value of a leaf output costs its energy
+			// (a value replaced at the same time is not a new edge)
+			if (w->numEdges() > edges && !isSystem())
+			{
+				if (!type_->isBuilt()) type_->build(this);
+				energy_t E = type_->energy(i);
+				ctx.addEnergy(E, T);
+				if (ctx.activity_) ctx.activity_->add(this, E);
+			}
+
+			// values before the current time will never be read again
+			if (ctx.htype_ == SIMHISTORY_STREAM)
+				w->forget(ctx.time_);
+			wireDidChange(ctx,w,T);
+		}
+	}
 	return changed;
 }
 
@@ -344,6 +419,29 @@ void Module::holdOutput(int i)
 	outWires_[i]->hold();
 }
 
+void Module::probeInput(int i)
+{
+	assert(i >= 0 && i < numInputs());
+	if (inWires_[i] == NULL)
+	{
+		inWires_[i] = new Wire();
+		if (!isSystem()) inWires_[i]->addReader(this, i);
+		else inWires_[i]->addAlias(this, i);
+	}
+	inWires_[i]->probe();
+}
+
+void Module::probeOutput(int i)
+{
+	assert(i >= 0 && i < numOutputs());
+	if (outWires_[i] == NULL)
+	{
+		outWires_[i] = new Wire();
+		if (!isSystem()) outWires_[i]->setWriter(this, i);
+	}
+	outWires_[i]->probe();
+}
+
 ////////////////////////////////////////////////////////////
 // Get signal metadata
 ////////////////////////////////////////////////////////////
@@ -440,8 +538,9 @@ bool Module::edge(int inum) const
 	Wire* w = inWires_[inum];
 	if (w)
 	{
-		const HPAIR_T& p = w->getPair(Module::simtime);
-		if (p.first == Module::simtime)
+		delay_t T = SimContext::current().time_;
+		const HPAIR_T& p = w->getPair(T);
+		if (p.first == T)
 			return true;
 	}
 	return false;
@@ -464,8 +563,9 @@ bool Module::posedge(int inum) const
 	Wire* w = inWires_[inum];
 	if (w)
 	{
-		const HPAIR_T& p = w->getPair(Module::simtime);
-		if (p.first == Module::simtime && p.second == HIGH)
+		delay_t T = SimContext::current().time_;
+		const HPAIR_T& p = w->getPair(T);
+		if (p.first == T && p.second == HIGH)
 			return true;
 	}
 	return false;
@@ -486,8 +586,9 @@ bool Module::negedge(int inum) const
 	Wire* w = inWires_[inum];
 	if (w)
 	{
-		const HPAIR_T& p = w->getPair(Module::simtime);
-		if (p.first == Module::simtime && p.second == LOW)
+		delay_t T = SimContext::current().time_;
+		const HPAIR_T& p = w->getPair(T);
+		if (p.first == T && p.second == LOW)
 			return true;
 	}
 	return false;
@@ -502,6 +603,26 @@ bool Module::negedge(const std::string& name) const
 	return negedge(p.low);
 }
 
+bool Module::edge(const InPort& h) const
+{
+	for (int i = h.low; i <= h.high; i++)
+		if (edge(i)) return true;
+
+	return false;
+}
+
+bool Module::posedge(const InPort& h) const
+{
+	assert(h.low == h.high);
+	return posedge(h.low);
+}
+
+bool Module::negedge(const InPort& h) const
+{
+	assert(h.low == h.high);
+	return negedge(h.low);
+}
+
 delay_t Module::fanout(int onum) const
 {
 	assert(onum >= 0 && onum < numOutputs());
@@ -510,11 +631,13 @@ delay_t Module::fanout(int onum) const
 	delay_t f = 0;
 
 	// sum all load factors for connected inputs
+	// (readers are leaf modules, so the loads come from their types)
 	for (PORTITER_T iter = w->beginReaders(); iter != w->endReaders(); iter++)
 	{
 		Module* m = (*iter).first;
 		int inum = (*iter).second;
-		f += m->load(inum);
+		m->type_->build(m);
+		f += m->type_->load(inum);
 	}
 
 	return f;
@@ -588,12 +711,13 @@ void Module::simPowerStats(energy_t* avgpow, energy_t* peakpow) const
 void Module::recordEnergies(std::map<delay_t,energy_t>& energyTable) const
 {
 	int N = numOutputs();
+	type_->build(const_cast<Module*>(this));
 	// for each output
 	for (int i = 0; i < N; i++)
 	{
 		assert(outWires_[i]);
-		// calculate energy to produce output
-		energy_t E = energy(i);
+		// energy to produce output
+		energy_t E = type_->energy(i);
 		// add energy to table for each time that the output changed
 		for (HITER_T iter = outWires_[i]->histBegin(); iter != outWires_[i]->histEnd(); iter++)
 		{
@@ -611,17 +735,43 @@ void Module::mergeInputWire(int inum, Wire* w)
 {
 	assert(w);
 	assert(inum >= 0 && inum < numInputs());
-	assert(inWires_[inum]);
+	Wire* old = inWires_[inum];
+	assert(old);
+	assert(!old->hasWriter());
+	if (old == w) return;
 
 #ifdef DEBUG
-std::cout << "mergeInputWire " << *this << " input " << inum << " wire " << inWires_[inum] 
+std::cout << "mergeInputWire " << *this << " input " << inum << " wire " << old
           << ", with wire " << w << std::endl;
 #endif
 
-	w->addReader(this, inum);
+	// Every module input that holds the old wire is one of its readers (leaf
+	// modules) or aliases (system modules), so only those are moved to the
+	// new wire, and the hierarchy is never searched.
+	old->retain();
+	for (PORTITER_T iter = old->beginReaders(); iter != old->endReaders(); iter++)
+	{
+		Module* m = (*iter).first;
+		int i = (*iter).second;
+		assert(m->inWires_[i] == old);
+		m->inWires_[i] = w->retain();
+		old->release();
+		w->addReader(m, i);
+	}
+	const std::vector<PORT_T>& aliases = old->aliases();
+	for (size_t k = 0; k < aliases.size(); k++)
+	{
+		Module* m = aliases[k].first;
+		int i = aliases[k].second;
+		assert(m->inWires_[i] == old);
+		m->inWires_[i] = w->retain();
+		old->release();
+		w->addAlias(m, i);
+	}
 
-	inWires_[inum]->release();
-	inWires_[inum] = w->retain();
+	// keep probe on the merged wire
+	if (old->isProbed()) w->probe();
+	old->release();
 }
 
 void Module::connect(int onum, Module* other, int inum)
@@ -676,39 +826,72 @@ void Module::connect(int onum, Module* other, int inum)
 // Simulation methods
 ////////////////////////////////////////////////////////////
 
-// global simulation state
-SimQueue*      Module::simqueue = NULL;
-delay_t         Module::simtime = 0;
-const SimQueue::QItem* simqitem = NULL;
+void Module::finalize()
+{
+	if (isSystem()) return;
+	buildTiming();
+
+	// seal the reader arrays of our wires
+	for (WIREITER_T iter = inWires_.begin(); iter != inWires_.end(); iter++)
+		if (*iter && !(*iter)->isSealed()) (*iter)->seal();
+	for (WIREITER_T iter = outWires_.begin(); iter != outWires_.end(); iter++)
+		if (*iter && !(*iter)->isSealed()) (*iter)->seal();
+}
+
+void Module::buildTiming()
+{
+	int Nout = numOutputs();
+
+	// delays only depend on the module type, so they're built once per type
+	type_->build(this);
+
+	// fanouts depend on the connections
+	fanoutTbl_.resize(Nout);
+	for (int o = 0; o < Nout; o++)
+		fanoutTbl_[o] = fanout(o);
+}
 
 // instance method
 delay_t Module::delayToOutput(int onum)
 {
 	assert(onum >= 0 && onum < numOutputs());
 	delay_t maxdelay = DELAY_T_MIN;
+	const SimQueue::QItem* item = SimContext::current().item_;
+
+	// tables are built on first use (and after connections change)
+	if (fanoutTbl_.empty())
+		buildTiming();
+	int Nin = numInputs();
+	const delay_t* delays = type_->delays(onum);
 
-	if (simqitem)
+	if (item)
 	{
 		// currently simulating this module...
-		// get max of delay(i,onum) for each i in simqitem->inputs
-		assert(simqitem->module == this);
-		assert(simqitem->inputs.size() > 0);
-
-		for (std::set<int>::iterator iter = simqitem->inputs.begin(); iter != simqitem->inputs.end(); iter++)
+		// get max of delay(i,onum) for each i in item->inputs
+		assert(item->key == this);
+		assert(item->inputs.size() > 0);
+
+		// walk the set bits one word at a time
+		const uint64_t* words = item->inputs.data();
+		int Nw = item->inputs.numWords();
+		for (int w = 0; w < Nw; w++)
 		{
-			delay_t T = delay(*iter, onum);
-			if (T > maxdelay) maxdelay = T;
+			for (uint64_t bits = words[w]; bits; bits &= bits - 1)
+			{
+				int inum = 64*w + __builtin_ctzll(bits);
+				delay_t T = delays[inum];
+				if (T > maxdelay) maxdelay = T;
+			}
 		}
 	}
 	else
 	{
 		// called propagate() at start of simulation...
 		// get max of delay(i,onum) for each i that was set for T=0
-		int Nin = numInputs();
 		for (int i = 0; i < Nin; i++)
 		{
 			if (!edge(i)) continue;
-			delay_t T = delay(i, onum);
+			delay_t T = delays[i];
 			if (T > maxdelay) maxdelay = T;
 		}
 		// if no input had edge, then no input was set, so simulation will do nothing
@@ -717,7 +900,7 @@ delay_t Module::delayToOutput(int onum)
 #if USE_FANOUT_DELAY
 	// include fanout load in delay calculation
 	if (maxdelay >= 0)
-		maxdelay += fanout(onum);
+		maxdelay += fanoutTbl_[onum];
 #endif
 
 	// We call this method before we know if an output changed.
@@ -728,11 +911,11 @@ delay_t Module::delayToOutput(int onum)
 }
 
 // static method
-void Module::wireDidChange(Wire* w, delay_t T)
+void Module::wireDidChange(SimContext& ctx, Wire* w, delay_t T)
 {
 	assert(w);
 	assert(T >= 0);
-	assert(simqueue);
+	assert(ctx.queue_);
 
 #ifdef DEBUG
 PORT_T& wp = w->getWriter();
@@ -742,28 +925,64 @@ std::cout << "wireDidChange T=" << T <<
 #endif
 
 	// add all readers of this Wire to sim queue
-	for (PORTITER_T iter = w->beginReaders(); iter != w->endReaders(); iter++)
+	// (from the sealed array, built on first change if finalize() wasn't called)
+	if (!w->isSealed())
+		w->seal();
+	const PORT_T* readers = w->sealedReaders();
+	int N = w->numReaders();
+	for (int k = 0; k < N; k++)
 	{
-		Module* m = (*iter).first;
-		int inum = (*iter).second;
-		simqueue->push(m, T, inum);
+		Module* m = readers[k].first;
+		ctx.queue_->push(m, T, readers[k].second, m->numInputs());
 	}
 }
 
 // static method
 delay_t Module::simTime()
 {
-	return Module::simtime;
+	return SimContext::current().time();
 }
 
 // instance method
 void Module::simulate()
 {
+	simulate(SimContext::current());
+}
+
+// instance method
+void Module::simulate(SimContext& ctx)
+{
+	// evaluate each leaf module once (if the design can be levelized)
+	if (ctx.mode_ == SIMMODE_LEVELIZED && simLevelized(ctx))
+		return;
+
 	// wrapper for static methods
 	MSET_T roots;
 	roots.insert(this);
-	Module::simStart(roots, DELAY_T_MAX);
-	Module::simReset();
+	Module::simStart(ctx, roots, DELAY_T_MAX);
+	ctx.reset();
+}
+
+bool Module::simLevelized(SimContext& ctx)
+{
+	// flatten and levelize on first use, and again after any rewiring
+	// (the delays of the netlist are looked up in this context)
+	SimContext* prev = SimContext::current_;
+	SimContext::current_ = &ctx;
+	if (levelSim_ && levelVersion_ != Wire::structureVersion())
+	{
+		delete levelSim_;
+		levelSim_ = NULL;
+	}
+	if (!levelSim_ && Netlist::canFlatten(*this))
+	{
+		levelSim_ = new LevelSim(*this);
+		levelVersion_ = Wire::structureVersion();
+	}
+	bool ok = levelSim_ && !levelSim_->hasLoops();
+	if (ok) levelSim_->simulate(ctx.time_);
+	SimContext::current_ = prev;
+	return ok;
 }
 
 // static method
@@ -791,62 +1010,174 @@ void Module::simStart(delay_t steps, int Nmod, Module* m, ...)
 
 // static method
 void Module::simStep(delay_t steps)
+{
+	simStep(SimContext::current(), steps);
+}
+
+// static method
+void Module::simStep(SimContext& ctx, delay_t steps)
 {
 	// continue an already-running simulation
-	assert(simqueue);
+	assert(ctx.queue_);
 	assert(steps > 0);
-	delay_t Tend = (DELAY_T_MAX - simtime <= steps) ? DELAY_T_MAX : (simtime + steps);
+	delay_t Tend = (DELAY_T_MAX - ctx.time_ <= steps) ? DELAY_T_MAX : (ctx.time_ + steps);
+
+	// modules read the time (etc.) from the current context
+	SimContext* prev = SimContext::current_;
+	SimContext::current_ = &ctx;
+	SimQueue* queue = ctx.queue_;
+	bool parallel = (ctx.threads_ > 1);
+	if (parallel)
+		ctx.startPool();
 
 	// MAIN SIMULATION LOOP
 	// propagate until there are no more wire updates, or end time is reached
-	while (!simqueue->empty())
+	while (!queue->empty())
 	{
 		// get the next item in the queue
-		simqitem = simqueue->top();
+		const SimQueue::QItem* item = queue->top();
 		// stop if its time is past our ending time
-		if (simqitem->T >= Tend) break;
+		// (the simulation has reached Tend, so the next step starts from there)
+		if (item->T >= Tend)
+		{
+			ctx.time_ = Tend;
+			break;
+		}
 #ifdef DEBUG
-std::cout << "propagating: " << *simqitem->module << ", T=" << simqitem->T << std::endl;
+std::cout << "propagating: " << *item->key << ", T=" << item->T << std::endl;
 #endif
-		// set the current time
-		simtime = simqitem->T;
+		// set the current item and time
+		ctx.item_ = item;
+		ctx.time_ = item->T;
+		// propagate all items at this time in parallel
+		if (parallel && simParallel(ctx))
+			continue;
 		// propagate the inputs to outputs
-		simqitem->module->propagate();
+		item->key->propagate();
 		// remove the item from the queue
-		simqueue->pop();
+		queue->pop();
+	}
+	ctx.item_ = NULL;
+	// the power stats are final for the steps that were simulated
+	ctx.closeSteps(queue->empty() ? DELAY_T_MAX : ctx.time_);
+
+	SimContext::current_ = prev;
+}
+
+// fewest items at one time that are propagated in parallel
+static const int PARALLEL_MIN_ITEMS = 32;
+
+// static method
+void Module::propagateTask(void* arg, int i, int w)
+{
+	SimContext& ctx = *static_cast<SimContext*>(arg);
+
+	// propagate in the worker's lane, keeping the outputs of item i
+	SimContext* lane = ctx.lanes_[w];
+	lane->item_ = ctx.bucket_[i];
+	lane->time_ = ctx.time_;
+	lane->writes_ = &ctx.pending_[i];
+
+	SimContext* prev = SimContext::current_;
+	SimContext::current_ = lane;
+	lane->item_->key->propagate();
+	SimContext::current_ = prev;
+
+	lane->writes_ = NULL;
+	lane->item_ = NULL;
+}
+
+// static method
+bool Module::simParallel(SimContext& ctx)
+{
+	std::vector<const SimQueue::QItem*>& bucket = ctx.bucket_;
+	ctx.queue_->topAll(bucket);
+	int N = bucket.size();
+	if (N < PARALLEL_MIN_ITEMS)
+		return false;
+
+	// propagate all items (outputs are kept in ctx.pending_)
+	if ((int)ctx.pending_.size() < N)
+		ctx.pending_.resize(N);
+	ctx.pool_->run(N, propagateTask, &ctx);
+
+	// set the outputs in queue order (same results as propagating one at a time)
+	for (int i = 0; i < N; i++)
+	{
+		std::vector<SimWrite>& writes = ctx.pending_[i];
+		ctx.item_ = bucket[i];
+		for (size_t k = 0; k < writes.size(); k++)
+			writes[k].module->setOutput(writes[k].onum, writes[k].b, writes[k].T);
+		writes.clear();
 	}
+
+	// remove the items from the queue
+	for (int i = 0; i < N; i++)
+		ctx.queue_->pop();
+	return true;
 }
 
 // static method
 void Module::simStart(const MSET_T& roots, delay_t steps)
 {
-	// setup global simulation state
-	simReset();
+	simStart(SimContext::current(), roots, steps);
+}
+
+// static method
+void Module::simStart(SimContext& ctx, const MSET_T& roots, delay_t steps)
+{
+	// setup simulation state
+	ctx.reset();
+	ctx.resetPower();
 	assert(!roots.empty());
-	simqueue = new SimQueue();
+	if (ctx.qtype_ == SIMQUEUE_WHEEL)
+		ctx.queue_ = new WheelQueue();
+	else
+		ctx.queue_ = new SetQueue();
 
 	// propagate from root modules
+	SimContext* prev = SimContext::current_;
+	SimContext::current_ = &ctx;
 	for (MITER_T iter = roots.begin(); iter != roots.end(); iter++)
 		(*iter)->propagate();
+	SimContext::current_ = prev;
 
 	// simulate for requested number of time steps
-	simStep(steps);
+	simStep(ctx, steps);
 }
 
-// see SystemModule.cpp
-void clearDelayTables();
+// static method
+void Module::simUseQueue(simqueue_t type)
+{
+	SimContext::defaultQueue = type;
+	SimContext::current().useQueue(type);
+}
+
+// static method
+void Module::simUseHistory(simhistory_t type)
+{
+	SimContext::defaultHistory = type;
+	SimContext::current().useHistory(type);
+}
+
+// static method
+void Module::simUseMode(simmode_t type)
+{
+	SimContext::defaultMode = type;
+	SimContext::current().useMode(type);
+}
+
+// static method
+void Module::simUseThreads(int N)
+{
+	SimContext::defaultThreads = N;
+	SimContext::current().useThreads(N);
+}
 
 // static method
 void Module::simReset()
 {
-	if (simqueue != NULL)
-	{
-		delete simqueue;
-		simqueue = NULL;
-	}
-	simtime = 0;
-	simqitem = NULL;
-	clearDelayTables();
+	SimContext::current().reset();
 }
 
 ////////////////////////////////////////////////////////////
@@ -919,13 +1250,25 @@ Port Module::OUT(const std::string& name, int high, int low)
 	return p(high,low);
 }
 
-const Port& Module::port(const std::string& name) const
+Port Module::port(const std::string& name) const
 {
-	NAMEITER_T iter = nameMap_.find(name);
-	assert(iter != nameMap_.end());
-	const Port& p = (*iter).second;
-	assert(p.module == this);
-	return p;
+	const PortDef* p = type_->findPort(name);
+	assert(p);
+	return Port(const_cast<Module*>(this), p->low, p->high, p->isOutput);
+}
+
+InPort Module::inPort(const std::string& name) const
+{
+	const Port& p = port(name);
+	assert(!p.isOutput);
+	return InPort(p.low, p.high);
+}
+
+OutPort Module::outPort(const std::string& name) const
+{
+	const Port& p = port(name);
+	assert(p.isOutput);
+	return OutPort(p.low, p.high);
 }
 
 Port Module::operator()(const std::string& name)
@@ -952,13 +1295,14 @@ void operator<=(const Port& p, Bit b)
 	// set a single input/output bit
 	assert(p.module);
 	assert(p.low == p.high);
+	delay_t T = Module::simTime();
 	if (p.isOutput)
 	{
 		delay_t dT = p.module->delayToOutput(p.low);
 		if (dT <= 0) return;
-		p.module->setOutput(p.low, b, Module::simtime+dT);
+		p.module->setOutput(p.low, b, T+dT);
 	}
-	else p.module->setInput(p.low, b, Module::simtime);
+	else p.module->setInput(p.low, b, T);
 }
 
 void operator<=(const Port& p, const BitVector& vec)
@@ -967,6 +1311,7 @@ void operator<=(const Port& p, const BitVector& vec)
 	assert(p.module);
 	int N = p.width();
 	assert(N == vec.width());
+	delay_t T = Module::simTime();
 
 	for (int i = 0; i < N; i++)
 	{
@@ -974,9 +1319,9 @@ void operator<=(const Port& p, const BitVector& vec)
 		{
 			delay_t dT = p.module->delayToOutput(p.low+i);
 			if (dT <= 0) continue;
-			p.module->setOutput(p.low+i, vec.get(i), Module::simtime+dT);
+			p.module->setOutput(p.low+i, vec.get(i), T+dT);
 		}
-		else p.module->setInput(p.low+i, vec.get(i), Module::simtime);
+		else p.module->setInput(p.low+i, vec.get(i), T);
 	}
 }
 
@@ -986,6 +1331,7 @@ void operator<=(const Port& p, value_t val)
 	assert(p.module);
 	assert(p.low <= p.high);
 	assert(p.width() <= VALUE_T_BITS);
+	delay_t T = Module::simTime();
 
 	for (int i = p.low; i <= p.high; i++, val>>=1)
 	{
@@ -993,9 +1339,9 @@ void operator<=(const Port& p, value_t val)
 		{
 			delay_t dT = p.module->delayToOutput(i);
 			if (dT <= 0) continue;
-			p.module->setOutput(i, Bit(val & 1), Module::simtime+dT);
+			p.module->setOutput(i, Bit(val & 1), T+dT);
 		}
-		else p.module->setInput(i, Bit(val & 1), Module::simtime);
+		else p.module->setInput(i, Bit(val & 1), T);
 	}
 }
 
@@ -1009,13 +1355,14 @@ void operator<=(const Port& po, const Port& pi)
 	assert(N == pi.width());
 	assert(po.isOutput);
 	assert(!pi.isOutput);
+	delay_t T = Module::simTime();
 
 	for (int i = 0; i < N; i++)
 	{
 		delay_t dT = m->delayToOutput(po.low+i);
 		if (dT <= 0) continue;
-		Bit b = m->getInput(pi.low+i, Module::simtime);
-		m->setOutput(po.low+i, b, Module::simtime+dT);
+		Bit b = m->getInput(pi.low+i, T);
+		m->setOutput(po.low+i, b, T+dT);
 	}
 }
 
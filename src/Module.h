@@ -12,11 +12,16 @@
 
 #include "BitHistory.h"
 #include "BitVector.h"
+#include "Bit64.h"
+#include "Pool.h"
 
 class Wire;		// Wire.h
 struct Port;	// this file
 class Module;	// this file
 class SimQueue;	// SimQueue.h
+class SimContext;	// SimContext.h
+class LevelSim;	// LevelSim.h
+class ModuleType;	// ModuleType.h
 
 // area estimate
 typedef float area_t;
@@ -28,6 +33,37 @@ typedef float energy_t;
 typedef std::set<Module*> MSET_T;
 typedef MSET_T::const_iterator MITER_T;
 
+// simulation queue implementations (see SimQueue.h)
+enum simqueue_t {SIMQUEUE_SET, SIMQUEUE_WHEEL};
+
+// wire history modes
+// SIMHISTORY_FULL   : every wire keeps all of its values
+// SIMHISTORY_STREAM : wires keep only the current value (and pending future values),
+//                     except for probed wires which keep all of their values
+enum simhistory_t {SIMHISTORY_FULL, SIMHISTORY_STREAM};
+
+// simulation modes
+// SIMMODE_TIMED     : event-driven simulation with delays
+// SIMMODE_LEVELIZED : each leaf module is evaluated once in level order, with no
+//                     delays (only the final values are set, see LevelSim.h)
+enum simmode_t {SIMMODE_TIMED, SIMMODE_LEVELIZED};
+
+// Handle to a named input (or output) bit range, resolved once by
+// Module::inPort() (or outPort()), usually in the constructor.
+// IN()/OUT()/edge() with a handle don't look up the name, so propagate()
+// should use handles. Handles only hold bit numbers, so copies of a module
+// can use the same handles.
+template<bool OUTPUT>
+struct PortHandle
+{
+	int low, high;
+	PortHandle() : low(0), high(-1) {}
+	PortHandle(int l, int h) : low(l), high(h) {}
+	inline int width() const { return high - low + 1; }
+};
+typedef PortHandle<false> InPort;
+typedef PortHandle<true> OutPort;
+
 // The abstract base class for all modules.
 // A module has an arbitrary number of 1-bit inputs and outputs.
 // Ranges of inputs/outputs can have (string) names.
@@ -41,20 +77,23 @@ private:
 	std::vector<Wire*> outWires_;
 	typedef std::vector<Wire*>::iterator WIREITER_T;
 
-	// map from signal names to ports
-	typedef std::map<std::string,Port> SIGNAMEMAP_T;
-	typedef std::pair<std::string,Port> NAMEPAIR_T;
-	typedef SIGNAMEMAP_T::const_iterator NAMEITER_T;
-	SIGNAMEMAP_T nameMap_;
+	// shared classname, port names and leaf tables (see ModuleType.h)
+	ModuleType* type_;
 
-	// simulation state
-	static SimQueue* simqueue;
-	static delay_t simtime;
+	// levelized copy of this module (see simUseMode)
+	// and the wire structure it was built from (see Wire::structureVersion)
+	LevelSim* levelSim_;
+	unsigned levelVersion_;
+
+	// elaborated fanout of each output of a leaf module (see finalize)
+	// (cleared when an output wire gets a new reader)
+	// the delays are shared by all modules of the same type
+	std::vector<delay_t> fanoutTbl_;
 
 protected:
-	// uniquely identifies class+configuration
-	// must be set by subclasses
-	std::string classname_;
+	// set the name that uniquely identifies class+configuration
+	// must be called by subclasses
+	void setClassname(const std::string& name);
 
 	// add some number of input/output bits
 	void addInputs(int N);
@@ -72,7 +111,8 @@ protected:
 	void addOutput(const std::string& name, int N=1);
 
 	// replace our input wire with given one, merging readers
-	virtual void mergeInputWire(int inum, Wire* w);
+	// (every module input holding the old wire moves to the new one)
+	void mergeInputWire(int inum, Wire* w);
 
 	// set output bits from input bits
 	// this is the where the simulation of functionality happens
@@ -92,6 +132,15 @@ protected:
 	bool negedge(int inum) const;
 	bool negedge(const std::string& name) const; // must be 1-bit
 
+	// same, with port handles
+	bool edge(const InPort& h) const;
+	bool posedge(const InPort& h) const;
+	bool negedge(const InPort& h) const;
+
+	// resolve a named input/output into a handle
+	InPort inPort(const std::string& name) const;
+	OutPort outPort(const std::string& name) const;
+
 	// copy constructor (rarely used)
 	Module(const Module& other);
 
@@ -102,9 +151,18 @@ public:
 	// destructor
 	virtual ~Module();
 
+	// modules (and arrays of them) are allocated from the Pool
+	static void* operator new(size_t n) { return Pool::alloc(n); }
+	static void operator delete(void* p, size_t n) { Pool::free(p, n); }
+	static void* operator new[](size_t n) { return Pool::alloc(n); }
+	static void operator delete[](void* p, size_t n) { Pool::free(p, n); }
+
 	// get classname
 	const std::string& classname() const;
 
+	// get the shared type description
+	const ModuleType* type() const { return type_; }
+
 #ifdef MOD_EXTRA
 	// user-defined tag for printing/debugging
 	int tag;
@@ -128,10 +186,27 @@ public:
 	// get energy to produce output
 	virtual energy_t energy(int onum) const;
 
+	// compute output bits from input bits without the simulator
+	// (used by compiled netlists, see Netlist.h)
+	// `in` has numInputs() bits, `out` has numOutputs() bits, and `changed`
+	// has the inputs that changed (input i is bit i%64 of word i/64)
+	// returns false if the outputs are not set
+	virtual bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const;
+
+	// is evaluate() defined?
+	virtual bool hasEvaluate() const;
+
+	// compute outputs for 64 input patterns at once (see PatternSim.h)
+	// every input is treated as changed, and `out` has the current outputs
+	// (the default calls evaluate() for each pattern)
+	virtual void evaluate64(const Bit64* in, Bit64* out) const;
+
 	// get static critical path (and optionally the input/output pair)
-	delay_t criticalPath(int* inum_p=NULL, int* onum_p=NULL);
+	virtual delay_t criticalPath(int* inum_p=NULL, int* onum_p=NULL);
 
-	// get power (average,peak)
+	// get power (average,peak) from the wire histories
+	// (only counts wires with full history, see simUseHistory;
+	// SimContext::powerStats() has the same stats without a history scan)
 	void simPowerStats(energy_t* avgpow, energy_t* peakpow) const;
 
 	// get number of input bits
@@ -181,6 +256,9 @@ public:
 	// mark input/output as constant-valued
 	void holdInput(int i);
 	void holdOutput(int i);
+	// keep full history of input/output (see simUseHistory)
+	void probeInput(int i);
+	void probeOutput(int i);
 
 	// get an input/output port for use with special operators
 	Port IN(int i);
@@ -195,11 +273,17 @@ public:
 	Port OUT(const std::string& name, int i);
 	Port OUT(const std::string& name, int high, int low);
 
+	// same, with port handles (no name lookup)
+	inline Port IN(const InPort& h);
+	inline Port IN(const InPort& h, int i);
+	inline Port OUT(const OutPort& h);
+	inline Port OUT(const OutPort& h, int i);
+
 	Port operator()(const std::string& name);
 	Port operator()(const std::string& name, int i);
 	Port operator()(const std::string& name, int high, int low);
 
-	const Port& port(const std::string& name) const;
+	Port port(const std::string& name) const;
 
 	// connect this module's output to another module's input
 	// (usually called indirectly from a >> operator)
@@ -208,10 +292,17 @@ public:
 	// reset (clear history) all input/output wires
 	virtual void reset();
 
+	// precompute the delay and fanout tables and the sealed wire readers
+	// used during simulation (for all leaf modules; otherwise they're built on first use)
+	virtual void finalize();
+
 	// simulate this module until all signals are stable
 	void simulate();
+	// same, with the given context
+	void simulate(SimContext& ctx);
 
 	// STATIC SIMULATION METHODS
+	// these use the current thread's context (see SimContext.h)
 	// get current simulation time
 	static delay_t simTime();
 	// reset simulation state
@@ -222,14 +313,41 @@ public:
 	static void simStart(delay_t steps, int Nmod, Module* m,...);
 	// continue an existing simulation
 	static void simStep(delay_t steps=DELAY_T_MAX);
+	// choose the queue implementation for the next simStart()
+	// (also the default for new contexts)
+	static void simUseQueue(simqueue_t type);
+	// choose how much wire history to keep during simulation
+	// (also the default for new contexts)
+	static void simUseHistory(simhistory_t type);
+	// choose how many threads propagate modules at the same time step
+	// (also the default for new contexts)
+	static void simUseThreads(int N);
+	// choose timed or levelized simulation for simulate()
+	// (also the default for new contexts)
+	static void simUseMode(simmode_t type);
+
+	// same, with the given context
+	static void simStart(SimContext& ctx, const MSET_T& roots, delay_t steps=DELAY_T_MAX);
+	static void simStep(SimContext& ctx, delay_t steps=DELAY_T_MAX);
 
 private:
 	// Called by setOutput() when a wire value changed.
 	// During simulation, this will add items to the sim queue.
-	static void wireDidChange(Wire* w, delay_t T);
+	static void wireDidChange(SimContext& ctx, Wire* w, delay_t T);
+	// propagate all modules at the current time in parallel
+	// (returns false if there are too few to be worth it)
+	static bool simParallel(SimContext& ctx);
+	static void propagateTask(void* arg, int i, int w);
+	// simulate with a LevelSim
+	// (returns false if this module can't be levelized)
+	bool simLevelized(SimContext& ctx);
 	// called by setOutput() to determine delay to a given output
 	// (uses the input set from the sim queue)
 	delay_t delayToOutput(int onum);
+	// build the delay and fanout tables (the delays once per type)
+	void buildTiming();
+	// called by Wire when the readers of an output wire change
+	inline void readersChanged() { fanoutTbl_.clear(); }
 	// called by power() to determine power
 	// (map from time to total output energy at that time)
 	virtual void recordEnergies(std::map<delay_t,energy_t>& energyTable) const;
@@ -237,6 +355,12 @@ private:
 	// necessary so SystemModule has protected access to another Module
 	friend class SystemModule;
 
+	// compiled netlists need access to wires
+	friend class Netlist;
+
+	// wires invalidate the fanout tables
+	friend class Wire;
+
 	// operators need protected access
 	friend void operator<=(const Port&, Bit);
 	friend void operator<=(const Port&, const BitVector&);
@@ -316,6 +440,36 @@ struct Port
 		for (int i = low; i <= high; i++)
 			isOutput ? module->holdOutput(i) : module->holdInput(i);
 	}
+	// keep full history of wire(s)
+	void probe()
+	{
+		for (int i = low; i <= high; i++)
+			isOutput ? module->probeOutput(i) : module->probeInput(i);
+	}
 };
 
+// port handle methods (need Port)
+
+inline Port Module::IN(const InPort& h)
+{
+	return Port(this, h.low, h.high, false);
+}
+
+inline Port Module::IN(const InPort& h, int i)
+{
+	assert(i >= 0 && i < h.width());
+	return Port(this, h.low+i, h.low+i, false);
+}
+
+inline Port Module::OUT(const OutPort& h)
+{
+	return Port(this, h.low, h.high, true);
+}
+
+inline Port Module::OUT(const OutPort& h, int i)
+{
+	assert(i >= 0 && i < h.width());
+	return Port(this, h.low+i, h.low+i, true);
+}
+
 #endif // MODULE_H_
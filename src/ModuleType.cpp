@@ -0,0 +1,116 @@
+#include <cassert>
+#include <pthread.h>
+#include "ModuleType.h"
+
+// guards interning and table building (modules may be built on several threads)
+static pthread_mutex_t typeLock = PTHREAD_MUTEX_INITIALIZER;
+static int typeCount = 0;
+
+ModuleType::ModuleType() :
+	 built_(false)
+	,Nin_(0)
+	,Nout_(0)
+	,area_(0)
+{
+	typeCount++;
+}
+
+ModuleType* ModuleType::empty()
+{
+	static ModuleType* type = new ModuleType();
+	return type;
+}
+
+// append a decimal number to a key
+static void appendInt(std::string& key, int n)
+{
+	char buf[16];
+	int k = sizeof(buf);
+	unsigned u = (n < 0) ? -(unsigned)n : n;
+	do { buf[--k] = '0' + u % 10; u /= 10; } while (u);
+	if (n < 0) buf[--k] = '-';
+	key.append(buf + k, sizeof(buf) - k);
+}
+
+ModuleType* ModuleType::withClassname(const std::string& name)
+{
+	std::string key("C");
+	key += name;
+	return derive(key, &name, NULL, NULL);
+}
+
+ModuleType* ModuleType::withPort(const std::string& name, const PortDef& p)
+{
+	std::string key(p.isOutput ? "O" : "I");
+	appendInt(key, p.low);
+	key += ':';
+	appendInt(key, p.high);
+	key += ':';
+	key += name;
+	return derive(key, NULL, &name, &p);
+}
+
+ModuleType* ModuleType::derive(const std::string& key, const std::string* classname,
+                               const std::string* portname, const PortDef* port)
+{
+	pthread_mutex_lock(&typeLock);
+	std::map<std::string,ModuleType*>::iterator iter = next_.find(key);
+	ModuleType* type;
+	if (iter != next_.end())
+	{
+		type = (*iter).second;
+	}
+	else
+	{
+		// copy our definitions and add the new one
+		type = new ModuleType();
+		type->classname_ = classname_;
+		type->ports_ = ports_;
+		if (classname) type->classname_ = *classname;
+		if (port) type->ports_.insert(PORTMAP_T::value_type(*portname, *port));
+		next_.insert(std::make_pair(key, type));
+	}
+	pthread_mutex_unlock(&typeLock);
+	return type;
+}
+
+void ModuleType::build(Module* m)
+{
+	assert(m && !m->isSystem());
+	if (isBuilt()) return;
+
+	pthread_mutex_lock(&typeLock);
+	if (!built_)
+	{
+		// all instances must have the same configuration
+		// (the classname is how the modules say so)
+		assert(m->classname() == classname_);
+		Nin_ = m->numInputs();
+		Nout_ = m->numOutputs();
+		delays_.resize(Nin_*Nout_);
+		for (int o = 0; o < Nout_; o++)
+			for (int i = 0; i < Nin_; i++)
+				delays_[o*Nin_+i] = m->delay(i, o);
+		loads_.resize(Nin_);
+		for (int i = 0; i < Nin_; i++)
+			loads_[i] = m->load(i);
+		energies_.resize(Nout_);
+		for (int o = 0; o < Nout_; o++)
+			energies_[o] = m->energy(o);
+		area_ = m->area();
+
+		// tables must be visible before the flag
+		__atomic_store_n(&built_, true, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&typeLock);
+
+	assert(Nin_ == m->numInputs() && Nout_ == m->numOutputs());
+}
+
+int ModuleType::count()
+{
+	pthread_mutex_lock(&typeLock);
+	int n = typeCount;
+	pthread_mutex_unlock(&typeLock);
+	return n;
+}
@@ -0,0 +1,91 @@
+#ifndef MODULETYPE_H_
+#define MODULETYPE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include "Module.h"
+
+// a named input/output bit range of a module type
+struct PortDef
+{
+	int low, high;
+	bool isOutput;
+	PortDef(int l, int h, bool o) : low(l), high(h), isOutput(o) {}
+};
+
+// Shared ("flyweight") description of a module type: the classname, the named
+// ports, and the delay/load/energy/area of a leaf module.
+// All modules that are built the same way point to one ModuleType, so each
+// instance only keeps its own wires.
+//
+// Types are interned: a module starts with the empty type, and each
+// defineInput(), defineOutput() or setClassname() moves it to the type with
+// that definition added. That type is created the first time and shared by
+// every later module that makes the same definitions in the same order.
+// Types are never deleted.
+class ModuleType
+{
+public:
+	typedef std::map<std::string,PortDef> PORTMAP_T;
+	typedef PORTMAP_T::const_iterator DEFITER_T;
+
+private:
+	std::string classname_;
+	PORTMAP_T ports_;
+	// types with one more definition, by definition key
+	std::map<std::string,ModuleType*> next_;
+
+	// leaf tables, built once from the first instance (see build)
+	// (built_ is read without the lock, so it is only accessed atomically)
+	bool built_;
+	int Nin_, Nout_;
+	// delay(i,o) is delays_[o*Nin_+i]
+	std::vector<delay_t> delays_;
+	std::vector<delay_t> loads_;
+	std::vector<energy_t> energies_;
+	area_t area_;
+
+	ModuleType();
+	ModuleType(const ModuleType&);
+	ModuleType& operator=(const ModuleType&);
+
+	// get (or create) the type with one more definition
+	ModuleType* derive(const std::string& key, const std::string* classname,
+	                   const std::string* portname, const PortDef* port);
+
+public:
+	// the type of a module with no definitions
+	static ModuleType* empty();
+
+	// get the type with a classname or a named port added
+	ModuleType* withClassname(const std::string& name);
+	ModuleType* withPort(const std::string& name, const PortDef& p);
+
+	const std::string& classname() const { return classname_; }
+	const PORTMAP_T& ports() const { return ports_; }
+	// named port, or NULL
+	const PortDef* findPort(const std::string& name) const
+	{
+		DEFITER_T iter = ports_.find(name);
+		return (iter == ports_.end()) ? NULL : &(*iter).second;
+	}
+
+	// build the leaf tables by asking module m (an instance of this type),
+	// if they aren't built yet (thread-safe)
+	void build(Module* m);
+	inline bool isBuilt() const { return __atomic_load_n(&built_, __ATOMIC_ACQUIRE); }
+
+	// leaf tables (must be built)
+	inline const delay_t* delays(int onum) const { return Nin_ ? &delays_[onum*Nin_] : NULL; }
+	inline delay_t load(int inum) const { return loads_[inum]; }
+	inline energy_t energy(int onum) const { return energies_[onum]; }
+	inline area_t area() const { return area_; }
+	inline int numInputs() const { return Nin_; }
+	inline int numOutputs() const { return Nout_; }
+
+	// number of distinct types
+	static int count();
+};
+
+#endif // MODULETYPE_H_
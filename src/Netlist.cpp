@@ -0,0 +1,354 @@
+#include <map>
+#include <algorithm>
+#include "Netlist.h"
+#include "SystemModule.h"
+#include "SimContext.h"
+#include "Wire.h"
+#include "param.h"
+
+////////////////////////////////////////////////////////////
+// Flattening
+////////////////////////////////////////////////////////////
+
+// get net number of a wire (adding it if it's new)
+static int netIndex(Wire* w, std::map<Wire*,int>& netmap, std::vector<Wire*>& nets)
+{
+	std::map<Wire*,int>::iterator iter = netmap.find(w);
+	if (iter != netmap.end())
+		return (*iter).second;
+	int n = nets.size();
+	netmap[w] = n;
+	nets.push_back(w);
+	return n;
+}
+
+// add a cell (if it's new)
+static void addCell(Module* m, std::map<Module*,int>& cellmap, std::vector<Module*>& cells)
+{
+	if (cellmap.count(m)) return;
+	cellmap[m] = cells.size();
+	cells.push_back(m);
+}
+
+// static method
+void Netlist::collect(Module* m, std::vector<Module*>& leaves)
+{
+	if (!m->isSystem())
+	{
+		leaves.push_back(m);
+		return;
+	}
+	const MSET_T& subs = static_cast<SystemModule*>(m)->submodules_;
+	for (MITER_T iter = subs.begin(); iter != subs.end(); iter++)
+		collect(*iter, leaves);
+}
+
+// static method
+bool Netlist::canFlatten(Module& top)
+{
+	std::vector<Module*> leaves;
+	collect(&top, leaves);
+	for (size_t i = 0; i < leaves.size(); i++)
+		if (!leaves[i]->hasEvaluate())
+			return false;
+	return true;
+}
+
+Netlist::Netlist(Module& top) : top_(&top), maxIn_(0), maxOut_(0)
+{
+	std::map<Module*,int> cellmap;
+	std::map<Wire*,int> netmap;
+
+	// all leaf modules become cells
+	std::vector<Module*> leaves;
+	collect(&top, leaves);
+	for (size_t i = 0; i < leaves.size(); i++)
+		addCell(leaves[i], cellmap, cells_);
+
+	// cells propagated at the start are the readers of the system inputs
+	// (in the same order as SystemModule::propagate())
+	std::vector<Module*> roots;
+	if (top.isSystem())
+	{
+		int Nin = top.numInputs();
+		for (int i = 0; i < Nin; i++)
+			if (Wire* w = top.inWires_[i])
+				for (PORTITER_T iter = w->beginReaders(); iter != w->endReaders(); iter++)
+					roots.push_back((*iter).first);
+		std::sort(roots.begin(), roots.end());
+		roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+	}
+	else roots.push_back(&top);
+
+	for (size_t i = 0; i < roots.size(); i++)
+	{
+		addCell(roots[i], cellmap, cells_);
+		startCells_.push_back(cellmap[roots[i]]);
+	}
+
+	// modules outside the hierarchy that read our outputs are simulated too
+	for (size_t c = 0; c < cells_.size(); c++)
+	{
+		Module* m = cells_[c];
+		int Nout = m->numOutputs();
+		for (int o = 0; o < Nout; o++)
+			if (Wire* w = m->outWires_[o])
+				for (PORTITER_T iter = w->beginReaders(); iter != w->endReaders(); iter++)
+					addCell((*iter).first, cellmap, cells_);
+	}
+
+	// pins, delays and nets
+	int C = cells_.size();
+	for (int c = 0; c < C; c++)
+	{
+		Module* m = cells_[c];
+		assert(m->hasEvaluate());
+		int Nin = m->numInputs();
+		int Nout = m->numOutputs();
+		if (Nin > maxIn_) maxIn_ = Nin;
+		if (Nout > maxOut_) maxOut_ = Nout;
+
+		inStart_.push_back(inNet_.size());
+		outStart_.push_back(outNet_.size());
+
+		for (int i = 0; i < Nin; i++)
+		{
+			Wire* w = m->inWires_[i];
+			inNet_.push_back(w ? netIndex(w, netmap, nets_) : -1);
+
+			// keep only the pairs that have a delay
+			arcStart_.push_back(arcOut_.size());
+			for (int o = 0; o < Nout; o++)
+			{
+				delay_t d = m->delay(i,o);
+				if (d == DELAY_T_MIN) continue;
+				arcOut_.push_back(o);
+				arcDelay_.push_back(d);
+			}
+		}
+
+		for (int o = 0; o < Nout; o++)
+		{
+			// output wires are created as in Module::setOutput()
+			Wire* w = m->outWires_[o];
+			if (w == NULL)
+			{
+				m->outWires_[o] = w = new Wire();
+				w->setWriter(m, o);
+			}
+			outNet_.push_back(netIndex(w, netmap, nets_));
+			outFanout_.push_back(m->fanout(o));
+		}
+	}
+	inStart_.push_back(inNet_.size());
+	outStart_.push_back(outNet_.size());
+	arcStart_.push_back(arcOut_.size());
+
+	// readers of each net
+	int N = nets_.size();
+	for (int n = 0; n < N; n++)
+	{
+		readStart_.push_back(readCell_.size());
+		Wire* w = nets_[n];
+		for (PORTITER_T iter = w->beginReaders(); iter != w->endReaders(); iter++)
+		{
+			// readers that aren't cells are on nets that are never written
+			std::map<Module*,int>::iterator c_iter = cellmap.find((*iter).first);
+			if (c_iter == cellmap.end()) continue;
+			readCell_.push_back((*c_iter).second);
+			readIn_.push_back((*iter).second);
+		}
+	}
+	readStart_.push_back(readCell_.size());
+}
+
+int Netlist::levelize(std::vector<int>& order, std::vector<int>& level, bool& loops) const
+{
+	int C = numCells();
+	int N = numNets();
+	int Nlevels = 0;
+
+	// writer cell of each net
+	std::vector<int> writer(N, -1);
+	for (int c = 0; c < C; c++)
+		for (int q = firstOutput(c); q < firstOutput(c) + numOutputs(c); q++)
+			writer[outputNet(q)] = c;
+
+	// number of input pins driven by cells that aren't done yet
+	std::vector<int> waiting(C, 0);
+	for (int c = 0; c < C; c++)
+		for (int i = firstInput(c); i < firstInput(c) + numInputs(c); i++)
+			if (inputNet(i) >= 0 && writer[inputNet(i)] >= 0)
+				waiting[c]++;
+
+	// cells with no driven inputs are level 0
+	order.clear();
+	level.assign(C, 0);
+	for (int c = 0; c < C; c++)
+		if (waiting[c] == 0)
+			order.push_back(c);
+
+	// each cell is done when all its drivers are done
+	for (size_t k = 0; k < order.size(); k++)
+	{
+		int c = order[k];
+		if (level[c] + 1 > Nlevels) Nlevels = level[c] + 1;
+		for (int q = firstOutput(c); q < firstOutput(c) + numOutputs(c); q++)
+		{
+			int n = outputNet(q);
+			for (int r = firstReader(n); r < endReader(n); r++)
+			{
+				int rc = readerCell(r);
+				if (level[c] + 1 > level[rc]) level[rc] = level[c] + 1;
+				if (--waiting[rc] == 0)
+					order.push_back(rc);
+			}
+		}
+	}
+
+	// cells in loops go last
+	loops = ((int)order.size() < C);
+	if (loops)
+	{
+		for (int c = 0; c < C; c++)
+		{
+			if (waiting[c] <= 0) continue;
+			level[c] = Nlevels;
+			order.push_back(c);
+		}
+		Nlevels++;
+	}
+	return Nlevels;
+}
+
+////////////////////////////////////////////////////////////
+// Simulation
+////////////////////////////////////////////////////////////
+
+NetlistSim::NetlistSim(const Netlist& net) :
+	 net_(net)
+	,hist_(net.numNets())
+	,forget_(net.numNets())
+	,time_(0)
+	,in_(std::max(net.maxInputs(),1))
+	,out_(std::max(net.maxOutputs(),1))
+	,maxdelay_(std::max(net.maxOutputs(),1))
+	,changed_((net.maxInputs()+63)/64 + 1)
+{
+}
+
+void NetlistSim::propagate(int c, const uint64_t* changed)
+{
+	const Netlist& nl = net_;
+	int Nin = nl.numInputs(c);
+	int Nout = nl.numOutputs(c);
+	int p0 = nl.firstInput(c);
+	int q0 = nl.firstOutput(c);
+	delay_t T = time_;
+
+	// read inputs at the current time
+	for (int i = 0; i < Nin; i++)
+	{
+		int n = nl.inputNet(p0+i);
+		in_[i] = (n < 0) ? Bit() : hist_[n].get(T);
+	}
+
+	if (!nl.cell(c)->evaluate(&in_[0], changed, &out_[0]))
+		return;
+
+	// get max delay to each output over the inputs that changed
+	// (same as Module::delayToOutput)
+	for (int o = 0; o < Nout; o++)
+		maxdelay_[o] = DELAY_T_MIN;
+	int Nw = (Nin + 63) / 64;
+	for (int w = 0; w < Nw; w++)
+	{
+		for (uint64_t bits = changed[w]; bits; bits &= bits - 1)
+		{
+			int p = p0 + 64*w + __builtin_ctzll(bits);
+			for (int a = nl.firstArc(p); a < nl.endArc(p); a++)
+			{
+				delay_t& d = maxdelay_[nl.arcOutput(a)];
+				if (nl.arcDelay(a) > d) d = nl.arcDelay(a);
+			}
+		}
+	}
+
+	// set outputs (same as Module::setOutput)
+	for (int o = 0; o < Nout; o++)
+	{
+		delay_t dT = maxdelay_[o];
+#if USE_FANOUT_DELAY
+		if (dT >= 0)
+			dT += nl.outputFanout(q0+o);
+#endif
+		if (dT <= 0) continue;
+
+		int n = nl.outputNet(q0+o);
+		assert(!nl.net(n)->isConstant());
+		delay_t Tout = T + dT;
+		if (!hist_[n].set(out_[o], Tout)) continue;
+		if (forget_[n]) hist_[n].forget(T);
+
+		// add all readers of the net to the queue
+		for (int r = nl.firstReader(n); r < nl.endReader(n); r++)
+		{
+			int rc = nl.readerCell(r);
+			queue_.push(rc, Tout, nl.readerInput(r), nl.numInputs(rc));
+		}
+	}
+}
+
+void NetlistSim::simulate(delay_t steps)
+{
+	assert(steps > 0);
+	const Netlist& nl = net_;
+	int N = nl.numNets();
+
+	// borrow the wire histories
+	bool stream = (SimContext::current().history() == SIMHISTORY_STREAM);
+	for (int n = 0; n < N; n++)
+	{
+		Wire* w = nl.net(n);
+		w->swapHistory(hist_[n]);
+		forget_[n] = stream && !w->isProbed();
+	}
+
+	queue_.clear();
+	time_ = 0;
+
+	// propagate the start cells from the inputs that have an edge at time 0
+	const std::vector<int>& start = nl.startCells();
+	for (size_t s = 0; s < start.size(); s++)
+	{
+		int c = start[s];
+		int Nin = nl.numInputs(c);
+		int p0 = nl.firstInput(c);
+		bool any = false;
+		std::fill(changed_.begin(), changed_.end(), 0);
+		for (int i = 0; i < Nin; i++)
+		{
+			int n = nl.inputNet(p0+i);
+			if (n < 0 || !hist_[n].hasTime(0)) continue;
+			changed_[i >> 6] |= (uint64_t)1 << (i & 63);
+			any = true;
+		}
+		// if no input had edge, nothing will be set
+		if (any) propagate(c, &changed_[0]);
+	}
+
+	// MAIN SIMULATION LOOP
+	delay_t Tend = (DELAY_T_MAX - time_ <= steps) ? DELAY_T_MAX : (time_ + steps);
+	while (!queue_.empty())
+	{
+		const QItemT<int>* item = queue_.top();
+		if (item->T >= Tend) break;
+		time_ = item->T;
+		propagate(item->key, item->inputs.data());
+		queue_.pop();
+	}
+
+	// give the histories back
+	for (int n = 0; n < N; n++)
+		nl.net(n)->swapHistory(hist_[n]);
+}
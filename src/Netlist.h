@@ -0,0 +1,146 @@
+#ifndef NETLIST_H_
+#define NETLIST_H_
+
+#include <vector>
+#include "Module.h"
+#include "SimQueue.h"
+
+class Wire;	// Wire.h
+
+// A Netlist is a flattened ("compiled") copy of a Module hierarchy.
+// Every leaf Module becomes a cell and every Wire becomes a net.
+// Connections, delays and loads are stored in flat arrays indexed by
+// cell, net and pin numbers, so simulations don't walk the hierarchy.
+// All leaf modules must define evaluate() (see canFlatten()).
+//
+// The netlist refers to the original modules and wires, which must
+// outlive it and must not be reconnected.
+class Netlist
+{
+private:
+	// the flattened module
+	Module* top_;
+	// cells (leaf modules)
+	std::vector<Module*> cells_;
+	// pins of cell c are [inStart_[c],inStart_[c+1]) and [outStart_[c],outStart_[c+1])
+	std::vector<int> inStart_;
+	std::vector<int> outStart_;
+	// net of each input/output pin (input nets are -1 if not connected)
+	std::vector<int> inNet_;
+	std::vector<int> outNet_;
+	// fanout load of each output pin
+	std::vector<delay_t> outFanout_;
+	// delays from each input pin are [arcStart_[p],arcStart_[p+1])
+	// as (output number within cell, delay) pairs
+	std::vector<int> arcStart_;
+	std::vector<int> arcOut_;
+	std::vector<delay_t> arcDelay_;
+
+	// nets (original wires)
+	std::vector<Wire*> nets_;
+	// readers of net n are [readStart_[n],readStart_[n+1])
+	// as (cell, input number within cell) pairs
+	std::vector<int> readStart_;
+	std::vector<int> readCell_;
+	std::vector<int> readIn_;
+
+	// cells that are propagated at the start of a simulation
+	std::vector<int> startCells_;
+
+	// widest cell
+	int maxIn_, maxOut_;
+
+	Netlist(const Netlist&);
+	Netlist& operator=(const Netlist&);
+
+	// add leaf modules under `m` to `leaves`
+	static void collect(Module* m, std::vector<Module*>& leaves);
+
+public:
+	// flatten the hierarchy under `top`
+	Netlist(Module& top);
+
+	// can the hierarchy under `top` be flattened?
+	static bool canFlatten(Module& top);
+
+	// the flattened module
+	inline Module* top() const { return top_; }
+
+	// sizes
+	inline int numCells() const { return (int)cells_.size(); }
+	inline int numNets() const { return (int)nets_.size(); }
+	inline int maxInputs() const { return maxIn_; }
+	inline int maxOutputs() const { return maxOut_; }
+
+	// cell info
+	inline Module* cell(int c) const { return cells_[c]; }
+	inline int numInputs(int c) const { return inStart_[c+1] - inStart_[c]; }
+	inline int numOutputs(int c) const { return outStart_[c+1] - outStart_[c]; }
+	inline int firstInput(int c) const { return inStart_[c]; }
+	inline int firstOutput(int c) const { return outStart_[c]; }
+
+	// pin info (pins are numbered over all cells)
+	inline int inputNet(int pin) const { return inNet_[pin]; }
+	inline int outputNet(int pin) const { return outNet_[pin]; }
+	inline delay_t outputFanout(int pin) const { return outFanout_[pin]; }
+	inline int firstArc(int pin) const { return arcStart_[pin]; }
+	inline int endArc(int pin) const { return arcStart_[pin+1]; }
+	inline int arcOutput(int a) const { return arcOut_[a]; }
+	inline delay_t arcDelay(int a) const { return arcDelay_[a]; }
+
+	// net info
+	inline Wire* net(int n) const { return nets_[n]; }
+	inline int firstReader(int n) const { return readStart_[n]; }
+	inline int endReader(int n) const { return readStart_[n+1]; }
+	inline int readerCell(int r) const { return readCell_[r]; }
+	inline int readerInput(int r) const { return readIn_[r]; }
+
+	// cells propagated at the start of a simulation
+	inline const std::vector<int>& startCells() const { return startCells_; }
+
+	// sort cells by level (each cell comes after the cells that drive its inputs)
+	// `order` gets the cells in level order and `level` the level of each cell
+	// cells in loops go last, on their own level (and `loops` is set)
+	// returns the number of levels
+	int levelize(std::vector<int>& order, std::vector<int>& level, bool& loops) const;
+};
+
+// Event-driven simulation of a Netlist.
+// Gives the same results as Module::simulate() on the top module:
+// all wire histories are the same afterwards.
+class NetlistSim
+{
+private:
+	const Netlist& net_;
+	// history of each net (borrowed from the wires during simulate())
+	std::vector<BitHistory> hist_;
+	// drop old values of each net (see Module::simUseHistory)
+	std::vector<char> forget_;
+	// queue of (cell,time) items
+	TimingWheel<int> queue_;
+	// current time
+	delay_t time_;
+
+	// scratch space for one cell
+	std::vector<Bit> in_;
+	std::vector<Bit> out_;
+	std::vector<delay_t> maxdelay_;
+	std::vector<uint64_t> changed_;
+
+	NetlistSim(const NetlistSim&);
+	NetlistSim& operator=(const NetlistSim&);
+
+	// evaluate cell `c` at the current time
+	void propagate(int c, const uint64_t* changed);
+
+public:
+	NetlistSim(const Netlist& net);
+
+	// simulate until all signals are stable (or for a number of time steps)
+	void simulate(delay_t steps=DELAY_T_MAX);
+
+	// get current simulation time
+	delay_t simTime() const { return time_; }
+};
+
+#endif // NETLIST_H_
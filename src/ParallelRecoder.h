@@ -10,10 +10,12 @@ class ParallelRecoder : public Module
 {
 	private:
 		int N_;
+		InPort y2jm1_, y2j_, y2jp1_, Xi_;
+		OutPort sign_, c_, one_, two_, Xo_;
 	public: 
 		ParallelRecoder(int N)
 		{
-			classname_ = "ParallelRecoder";
+			setClassname("ParallelRecoder");
 			addInput("y2j-1"); // bit to the right of the two multiplier bits
 			addInput("y2j"); 
 			addInput("y2j+1");
@@ -26,34 +28,67 @@ class ParallelRecoder : public Module
 			addOutput("Xo", N);
 
 			N_ = N;
+
+			y2jm1_ = inPort("y2j-1");
+			y2j_ = inPort("y2j");
+			y2jp1_ = inPort("y2j+1");
+			Xi_ = inPort("Xi");
+			sign_ = outPort("sign");
+			c_ = outPort("c");
+			one_ = outPort("one");
+			two_ = outPort("two");
+			Xo_ = outPort("Xo");
 		}
 
 		void propagate()
 		{
-			Bit btr = IN("y2j-1");
-			Bit y0 = IN("y2j");
-			Bit y1 = IN("y2j+1");
-			BitVector x = IN("Xi");
+			Bit btr = IN(y2jm1_);
+			Bit y0 = IN(y2j_);
+			Bit y1 = IN(y2jp1_);
+			BitVector x = IN(Xi_);
+#ifdef DEBUG
 			std::cout << "y2j-1 " << btr << std::endl;
 			std::cout << "y2j " << y0 << std::endl;
 			std::cout << "y2j+1 " << y1 << std::endl;
 			std::cout << "Xi " << x << std::endl;
-			OUT("sign") <= y1;
-			OUT("c") <= y1;
-			OUT("one") <= (y0 ^ btr); 
-			OUT("two") <= ((y1 & ~y0 & ~btr) | (~y1 & y0 & btr));
-			OUT("Xo") <= x;
+#endif
+			OUT(sign_) <= y1;
+			OUT(c_) <= y1;
+			OUT(one_) <= (y0 ^ btr); 
+			OUT(two_) <= ((y1 & ~y0 & ~btr) | (~y1 & y0 & btr));
+			OUT(Xo_) <= x;
 
 			// for (int i = 0; i < N_; i++)
 			// {
 			// 	OUT("Xo", i) <= x.get(i);
 			// }
 
-			std::cout << "sign " << OUT("sign") << std::endl;
-			std::cout << "c " << OUT("c") << std::endl;
-			std::cout << "one " << OUT("one") << std::endl;
-			std::cout << "two " << OUT("two") << std::endl;
-			std::cout << "Xo " << OUT("Xo") << std::endl;
+#ifdef DEBUG
+			std::cout << "sign " << OUT(sign_) << std::endl;
+			std::cout << "c " << OUT(c_) << std::endl;
+			std::cout << "one " << OUT(one_) << std::endl;
+			std::cout << "two " << OUT(two_) << std::endl;
+			std::cout << "Xo " << OUT(Xo_) << std::endl;
+#endif
+		}
+
+		bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+		{
+			Bit btr = in[0];
+			Bit y0 = in[1];
+			Bit y1 = in[2];
+			out[0] = y1;
+			out[1] = y1;
+			out[2] = (y0 ^ btr);
+			out[3] = ((y1 & ~y0 & ~btr) | (~y1 & y0 & btr));
+			for (int i = 0; i < N_; i++)
+				out[4+i] = in[3+i];
+			return true;
+		}
+
+		bool hasEvaluate() const
+		{
+			return true;
 		}
 
 		delay_t delay(int inum, int onum)
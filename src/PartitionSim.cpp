@@ -0,0 +1,448 @@
+#include <algorithm>
+#include "PartitionSim.h"
+#include "SimContext.h"
+#include "WorkPool.h"
+#include "Wire.h"
+#include "param.h"
+
+// add without going past DELAY_T_MAX
+static inline delay_t addDelay(delay_t T, delay_t dT)
+{
+	return (T >= DELAY_T_MAX - dT) ? DELAY_T_MAX : T + dT;
+}
+
+////////////////////////////////////////////////////////////
+// Partitioning
+////////////////////////////////////////////////////////////
+
+// Order the cells so that each cell comes right after the cells that drive it
+// (depth-first from the cells whose outputs aren't read by other cells).
+// Cutting this order into equal pieces keeps subtrees together.
+static void orderCells(const Netlist& nl, const std::vector<int>& writer, std::vector<int>& order)
+{
+	int C = nl.numCells();
+	std::vector<char> seen(C, 0);
+	std::vector<char> read(C, 0);
+	for (int n = 0; n < nl.numNets(); n++)
+		if (writer[n] >= 0 && nl.firstReader(n) < nl.endReader(n))
+			read[writer[n]] = 1;
+
+	// stack of (cell, next input pin to visit)
+	std::vector< std::pair<int,int> > stack;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int root = 0; root < C; root++)
+		{
+			// sinks first, then anything left over (cycles)
+			if (seen[root] || (pass == 0 && read[root])) continue;
+			seen[root] = 1;
+			stack.push_back(std::make_pair(root, nl.firstInput(root)));
+			while (!stack.empty())
+			{
+				int c = stack.back().first;
+				int& pin = stack.back().second;
+				if (pin == nl.firstInput(c) + nl.numInputs(c))
+				{
+					order.push_back(c);
+					stack.pop_back();
+					continue;
+				}
+				int n = nl.inputNet(pin++);
+				if (n < 0) continue;
+				int d = writer[n];
+				if (d < 0 || seen[d]) continue;
+				seen[d] = 1;
+				stack.push_back(std::make_pair(d, nl.firstInput(d)));
+			}
+		}
+	}
+	assert((int)order.size() == C);
+}
+
+PartitionSim::PartitionSim(const Netlist& net, int Nparts, int Nthreads) :
+	 net_(net)
+	,Nparts_(Nparts)
+	,pool_(NULL)
+	,parts_(Nparts)
+	,hist_(net.numNets())
+	,forget_(net.numNets())
+	,time_(0)
+	,tend_(DELAY_T_MAX)
+	,rounds_(0)
+	,messages_(0)
+{
+	assert(Nparts > 0);
+	assert(Nthreads > 0);
+	const Netlist& nl = net_;
+	int C = nl.numCells();
+	int N = nl.numNets();
+	int P = Nparts_;
+
+	// writer cell of each net
+	std::vector<int> writer(N, -1);
+	for (int c = 0; c < C; c++)
+		for (int q = nl.firstOutput(c); q < nl.firstOutput(c) + nl.numOutputs(c); q++)
+			writer[nl.outputNet(q)] = c;
+
+	// equal pieces of the cell order
+	std::vector<int> order;
+	orderCells(nl, writer, order);
+	cellPart_.assign(C, 0);
+	for (int k = 0; k < C; k++)
+		cellPart_[order[k]] = (int)((long long)k * P / C);
+
+	netPart_.assign(N, -1);
+	for (int n = 0; n < N; n++)
+		if (writer[n] >= 0)
+			netPart_[n] = cellPart_[writer[n]];
+
+	// ghosts: nets read by a partition that doesn't write them
+	// (ghost[p][n] is the ghost number, or -1)
+	std::vector< std::vector<int> > ghost(P, std::vector<int>());
+	for (int n = 0; n < N; n++)
+	{
+		int owner = netPart_[n];
+		remoteStart_.push_back(remotePart_.size());
+		if (owner < 0) continue;
+		for (int r = nl.firstReader(n); r < nl.endReader(n); r++)
+		{
+			int p = cellPart_[nl.readerCell(r)];
+			if (p == owner) continue;
+			if (ghost[p].empty()) ghost[p].assign(N, -1);
+			if (ghost[p][n] >= 0) continue;
+			ghost[p][n] = parts_[p].ghostNet.size();
+			parts_[p].ghostNet.push_back(n);
+			remotePart_.push_back(p);
+			remoteGhost_.push_back(ghost[p][n]);
+		}
+	}
+	remoteStart_.push_back(remotePart_.size());
+
+	for (int p = 0; p < P; p++)
+	{
+		Part& part = parts_[p];
+		part.ghosts.resize(part.ghostNet.size());
+		part.out.resize(P);
+		part.in.resize(std::max(nl.maxInputs(),1));
+		part.outBits.resize(std::max(nl.maxOutputs(),1));
+		part.maxdelay.resize(std::max(nl.maxOutputs(),1));
+		part.changed.resize((nl.maxInputs()+63)/64 + 1);
+	}
+
+	// input pins read their own partition's copy of the net
+	inHist_.assign(nl.firstInput(C), (BitHistory*)NULL);
+	for (int c = 0; c < C; c++)
+	{
+		int p = cellPart_[c];
+		for (int i = nl.firstInput(c); i < nl.firstInput(c) + nl.numInputs(c); i++)
+		{
+			int n = nl.inputNet(i);
+			if (n < 0) continue;
+			if (netPart_[n] < 0 || netPart_[n] == p)
+				inHist_[i] = &hist_[n];
+			else
+				inHist_[i] = &parts_[p].ghosts[ghost[p][n]];
+		}
+	}
+
+	// lookahead: smallest delay of an output on a cut net (at least 1,
+	// since outputs are never set at the current time)
+	lookahead_.assign(P*P, DELAY_T_MAX);
+	std::vector<delay_t> mindelay;
+	for (int c = 0; c < C; c++)
+	{
+		int q0 = nl.firstOutput(c);
+		mindelay.assign(nl.numOutputs(c), DELAY_T_MAX);
+		for (int i = nl.firstInput(c); i < nl.firstInput(c) + nl.numInputs(c); i++)
+			for (int a = nl.firstArc(i); a < nl.endArc(i); a++)
+				mindelay[nl.arcOutput(a)] = std::min(mindelay[nl.arcOutput(a)], nl.arcDelay(a));
+
+		for (int o = 0; o < nl.numOutputs(c); o++)
+		{
+			int n = nl.outputNet(q0+o);
+			if (mindelay[o] == DELAY_T_MAX) continue;
+			delay_t L = mindelay[o];
+#if USE_FANOUT_DELAY
+			L += nl.outputFanout(q0+o);
+#endif
+			if (L < 1) L = 1;
+			for (int r = remoteStart_[n]; r < remoteStart_[n+1]; r++)
+			{
+				delay_t& look = lookahead_[cellPart_[c]*P + remotePart_[r]];
+				look = std::min(look, L);
+			}
+		}
+	}
+
+	pool_ = new WorkPool(std::min(Nthreads, P));
+}
+
+PartitionSim::~PartitionSim()
+{
+	delete pool_;
+}
+
+int PartitionSim::numCutNets() const
+{
+	int cut = 0;
+	for (int n = 0; n < net_.numNets(); n++)
+		if (remoteStart_[n+1] > remoteStart_[n])
+			cut++;
+	return cut;
+}
+
+////////////////////////////////////////////////////////////
+// Simulation
+////////////////////////////////////////////////////////////
+
+void PartitionSim::propagate(int p, int c, const uint64_t* changed)
+{
+	const Netlist& nl = net_;
+	Part& part = parts_[p];
+	int Nin = nl.numInputs(c);
+	int Nout = nl.numOutputs(c);
+	int p0 = nl.firstInput(c);
+	int q0 = nl.firstOutput(c);
+	delay_t T = part.time;
+
+	// read inputs at the current time
+	for (int i = 0; i < Nin; i++)
+	{
+		BitHistory* h = inHist_[p0+i];
+		part.in[i] = h ? h->get(T) : Bit();
+	}
+
+	if (!nl.cell(c)->evaluate(&part.in[0], changed, &part.outBits[0]))
+		return;
+
+	// get max delay to each output over the inputs that changed
+	// (same as NetlistSim::propagate)
+	for (int o = 0; o < Nout; o++)
+		part.maxdelay[o] = DELAY_T_MIN;
+	int Nw = (Nin + 63) / 64;
+	for (int w = 0; w < Nw; w++)
+	{
+		for (uint64_t bits = changed[w]; bits; bits &= bits - 1)
+		{
+			int pin = p0 + 64*w + __builtin_ctzll(bits);
+			for (int a = nl.firstArc(pin); a < nl.endArc(pin); a++)
+			{
+				delay_t& d = part.maxdelay[nl.arcOutput(a)];
+				if (nl.arcDelay(a) > d) d = nl.arcDelay(a);
+			}
+		}
+	}
+
+	// set outputs
+	for (int o = 0; o < Nout; o++)
+	{
+		delay_t dT = part.maxdelay[o];
+#if USE_FANOUT_DELAY
+		if (dT >= 0)
+			dT += nl.outputFanout(q0+o);
+#endif
+		if (dT <= 0) continue;
+
+		int n = nl.outputNet(q0+o);
+		delay_t Tout = T + dT;
+		if (!hist_[n].set(part.outBits[o], Tout)) continue;
+		if (forget_[n]) hist_[n].forget(T);
+
+		// add readers in this partition to the queue
+		for (int r = nl.firstReader(n); r < nl.endReader(n); r++)
+		{
+			int rc = nl.readerCell(r);
+			if (cellPart_[rc] == p)
+				part.queue.push(rc, Tout, nl.readerInput(r), nl.numInputs(rc));
+		}
+		// tell the other partitions
+		for (int r = remoteStart_[n]; r < remoteStart_[n+1]; r++)
+			part.out[remotePart_[r]].push_back(Message(remoteGhost_[r], part.outBits[o], Tout));
+	}
+}
+
+void PartitionSim::start(int p)
+{
+	const Netlist& nl = net_;
+	Part& part = parts_[p];
+
+	// propagate the start cells from the inputs that have an edge at time 0
+	const std::vector<int>& start = nl.startCells();
+	for (size_t s = 0; s < start.size(); s++)
+	{
+		int c = start[s];
+		if (cellPart_[c] != p) continue;
+		int Nin = nl.numInputs(c);
+		int p0 = nl.firstInput(c);
+		bool any = false;
+		std::fill(part.changed.begin(), part.changed.end(), 0);
+		for (int i = 0; i < Nin; i++)
+		{
+			BitHistory* h = inHist_[p0+i];
+			if (h == NULL || !h->hasTime(0)) continue;
+			part.changed[i >> 6] |= (uint64_t)1 << (i & 63);
+			any = true;
+		}
+		if (any) propagate(p, c, &part.changed[0]);
+	}
+}
+
+void PartitionSim::deliver(int p)
+{
+	const Netlist& nl = net_;
+	Part& part = parts_[p];
+
+	for (int q = 0; q < Nparts_; q++)
+	{
+		std::vector<Message>& msgs = parts_[q].out[p];
+		for (size_t k = 0; k < msgs.size(); k++)
+		{
+			const Message& m = msgs[k];
+			int n = part.ghostNet[m.ghost];
+			BitHistory& h = part.ghosts[m.ghost];
+			// the owner only sends changes, so this is always a change
+			if (!h.set(m.b, m.T)) continue;
+			if (forget_[n]) h.forget(part.time);
+			for (int r = nl.firstReader(n); r < nl.endReader(n); r++)
+			{
+				int rc = nl.readerCell(r);
+				if (cellPart_[rc] == p)
+					part.queue.push(rc, m.T, nl.readerInput(r), nl.numInputs(rc));
+			}
+		}
+		msgs.clear();
+	}
+
+	// (the queue must not move past the safe time, messages can still come)
+	part.next = part.queue.nextTime();
+}
+
+void PartitionSim::bounds()
+{
+	int P = Nparts_;
+
+	// the next event of p is no sooner than its next queued event,
+	// or the bound of a partition q that sends to p plus their lookahead
+	// (shortest paths over the partition graph)
+	std::vector<char> done(P, 0);
+	for (int p = 0; p < P; p++)
+		parts_[p].bound = parts_[p].next;
+	for (int k = 0; k < P; k++)
+	{
+		int q = -1;
+		for (int p = 0; p < P; p++)
+			if (!done[p] && (q < 0 || parts_[p].bound < parts_[q].bound))
+				q = p;
+		done[q] = 1;
+		if (parts_[q].bound == DELAY_T_MAX) break;
+		for (int p = 0; p < P; p++)
+		{
+			delay_t L = lookahead_[q*P + p];
+			if (L == DELAY_T_MAX) continue;
+			delay_t T = addDelay(parts_[q].bound, L);
+			if (T < parts_[p].bound) parts_[p].bound = T;
+		}
+	}
+
+	// events before the earliest message that can still arrive are safe
+	for (int p = 0; p < P; p++)
+	{
+		delay_t safe = tend_;
+		for (int q = 0; q < P; q++)
+		{
+			delay_t L = lookahead_[q*P + p];
+			if (L == DELAY_T_MAX) continue;
+			safe = std::min(safe, addDelay(parts_[q].bound, L));
+		}
+		parts_[p].safe = safe;
+	}
+}
+
+void PartitionSim::advance(int p)
+{
+	Part& part = parts_[p];
+
+	// MAIN SIMULATION LOOP (of one partition)
+	while (const QItemT<int>* item = part.queue.topBefore(part.safe))
+	{
+		part.time = item->T;
+		propagate(p, item->key, item->inputs.data());
+		part.queue.pop();
+	}
+}
+
+// static method
+void PartitionSim::startTask(void* arg, int p, int w)
+{
+	static_cast<PartitionSim*>(arg)->start(p);
+}
+
+// static method
+void PartitionSim::deliverTask(void* arg, int p, int w)
+{
+	static_cast<PartitionSim*>(arg)->deliver(p);
+}
+
+// static method
+void PartitionSim::advanceTask(void* arg, int p, int w)
+{
+	static_cast<PartitionSim*>(arg)->advance(p);
+}
+
+void PartitionSim::simulate(delay_t steps)
+{
+	assert(steps > 0);
+	const Netlist& nl = net_;
+	int N = nl.numNets();
+	int P = Nparts_;
+
+	// borrow the wire histories
+	bool stream = (SimContext::current().history() == SIMHISTORY_STREAM);
+	for (int n = 0; n < N; n++)
+	{
+		Wire* w = nl.net(n);
+		w->swapHistory(hist_[n]);
+		forget_[n] = stream && !w->isProbed();
+	}
+
+	// ghosts start as copies of the nets
+	for (int p = 0; p < P; p++)
+	{
+		Part& part = parts_[p];
+		part.queue.clear();
+		part.time = 0;
+		for (size_t g = 0; g < part.ghostNet.size(); g++)
+			part.ghosts[g] = hist_[part.ghostNet[g]];
+	}
+
+	time_ = 0;
+	tend_ = steps;
+	rounds_ = 0;
+	messages_ = 0;
+
+	pool_->run(P, startTask, this);
+	while (true)
+	{
+		for (int q = 0; q < P; q++)
+			for (int p = 0; p < P; p++)
+				messages_ += parts_[q].out[p].size();
+		pool_->run(P, deliverTask, this);
+
+		// stop when there are no more events (before the end time)
+		delay_t next = DELAY_T_MAX;
+		for (int p = 0; p < P; p++)
+			next = std::min(next, parts_[p].next);
+		if (next >= tend_) break;
+
+		bounds();
+		pool_->run(P, advanceTask, this);
+		rounds_++;
+	}
+
+	for (int p = 0; p < P; p++)
+		time_ = std::max(time_, parts_[p].time);
+
+	// give the histories back
+	for (int n = 0; n < N; n++)
+		nl.net(n)->swapHistory(hist_[n]);
+}
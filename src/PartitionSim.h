@@ -0,0 +1,125 @@
+#ifndef PARTITIONSIM_H_
+#define PARTITIONSIM_H_
+
+#include <vector>
+#include "Netlist.h"
+
+class WorkPool;	// WorkPool.h
+
+// Conservative parallel simulation of a Netlist (Chandy-Misra-Bryant style).
+// The cells are split into partitions, each with its own event queue and clock.
+// A net belongs to the partition of the cell that writes it. Other partitions
+// that read the net keep a copy ("ghost") of its history, which is updated by
+// messages sent whenever the net changes.
+//
+// A partition never sends a message sooner than its lookahead: the smallest
+// delay()+fanout() of the outputs on cut nets. Before each round, a lower bound
+// on the time of the next event of every partition is computed from the next
+// queued events and the lookaheads between partitions. Each partition then
+// simulates (in parallel) every event that is earlier than all messages it can
+// still receive. Messages are delivered between rounds.
+//
+// Gives the same results as NetlistSim and Module::simulate().
+class PartitionSim
+{
+private:
+	// a change of a cut net, sent to a partition that reads it
+	struct Message
+	{
+		int ghost;	// ghost number in the receiving partition
+		Bit b;
+		delay_t T;
+		Message(int g, Bit bit, delay_t t) : ghost(g), b(bit), T(t) {}
+	};
+
+	// state of one partition
+	struct Part
+	{
+		// queue of (cell,time) items, and time of the last item
+		TimingWheel<int> queue;
+		delay_t time;
+		// next queued time, lower bound of the next event, safe time
+		delay_t next, bound, safe;
+		// histories of nets written by other partitions
+		std::vector<BitHistory> ghosts;
+		std::vector<int> ghostNet;
+		// messages to each partition (delivered in the next round)
+		std::vector< std::vector<Message> > out;
+
+		// scratch space for one cell
+		std::vector<Bit> in;
+		std::vector<Bit> outBits;
+		std::vector<delay_t> maxdelay;
+		std::vector<uint64_t> changed;
+	};
+
+	const Netlist& net_;
+	int Nparts_;
+	WorkPool* pool_;
+	std::vector<Part> parts_;
+
+	// partition of each cell, and of each net (-1 for nets no cell writes)
+	std::vector<int> cellPart_;
+	std::vector<int> netPart_;
+	// history read by each input pin (own net, ghost, or unwritten net)
+	std::vector<BitHistory*> inHist_;
+	// partitions that read net n are [remoteStart_[n],remoteStart_[n+1])
+	// as (partition, ghost number) pairs
+	std::vector<int> remoteStart_;
+	std::vector<int> remotePart_;
+	std::vector<int> remoteGhost_;
+	// lookahead from partition q to p (DELAY_T_MAX if q never sends to p)
+	std::vector<delay_t> lookahead_;
+
+	// history of each net (borrowed from the wires during simulate())
+	std::vector<BitHistory> hist_;
+	std::vector<char> forget_;
+
+	// current time, end time, and statistics
+	delay_t time_;
+	delay_t tend_;
+	int rounds_;
+	long messages_;
+
+	PartitionSim(const PartitionSim&);
+	PartitionSim& operator=(const PartitionSim&);
+
+	// evaluate cell `c` of partition `p` at the partition's time
+	void propagate(int p, int c, const uint64_t* changed);
+	// propagate the start cells of partition `p`
+	void start(int p);
+	// apply the messages sent to partition `p`, and find its next time
+	void deliver(int p);
+	// simulate the safe events of partition `p`
+	void advance(int p);
+	// compute the bound and safe time of every partition
+	void bounds();
+
+	static void startTask(void* arg, int p, int w);
+	static void deliverTask(void* arg, int p, int w);
+	static void advanceTask(void* arg, int p, int w);
+
+public:
+	// split `net` into Nparts partitions, simulated by Nthreads threads
+	PartitionSim(const Netlist& net, int Nparts, int Nthreads);
+	~PartitionSim();
+
+	// simulate until all signals are stable (or for a number of time steps)
+	void simulate(delay_t steps=DELAY_T_MAX);
+
+	// get current simulation time
+	delay_t simTime() const { return time_; }
+
+	// partitioning info
+	int numPartitions() const { return Nparts_; }
+	int partition(int c) const { return cellPart_[c]; }
+	delay_t lookahead(int q, int p) const { return lookahead_[q*Nparts_ + p]; }
+	// number of nets read by other partitions
+	int numCutNets() const;
+
+	// statistics of the last simulate()
+	int numRounds() const { return rounds_; }
+	long numMessages() const { return messages_; }
+};
+
+#endif // PARTITIONSIM_H_
@@ -0,0 +1,141 @@
+#include <map>
+#include <algorithm>
+#include "PatternSim.h"
+#include "Wire.h"
+
+PatternSim::PatternSim(const Netlist& net) :
+	 net_(net)
+	,value_(net.numNets())
+	,in_(std::max(net.maxInputs(),1))
+	,out_(std::max(net.maxOutputs(),1))
+{
+	Nlevels_ = net_.levelize(order_, level_, loops_);
+
+	// find the nets of the top-level ports
+	std::map<const Wire*,int> netmap;
+	for (int n = 0; n < net_.numNets(); n++)
+		netmap[net_.net(n)] = n;
+
+	Module* top = net_.top();
+	topIn_.assign(top->numInputs(), -1);
+	for (int i = 0; i < top->numInputs(); i++)
+	{
+		std::map<const Wire*,int>::iterator iter = netmap.find(top->inputWire(i));
+		if (iter != netmap.end()) topIn_[i] = (*iter).second;
+	}
+	topOut_.assign(top->numOutputs(), -1);
+	for (int o = 0; o < top->numOutputs(); o++)
+	{
+		std::map<const Wire*,int>::iterator iter = netmap.find(top->outputWire(o));
+		if (iter != netmap.end()) topOut_[o] = (*iter).second;
+	}
+
+	reset();
+}
+
+void PatternSim::reset()
+{
+	for (int n = 0; n < net_.numNets(); n++)
+		value_[n] = Bit64(net_.net(n)->get());
+}
+
+void PatternSim::simulate()
+{
+	const Netlist& nl = net_;
+	int C = order_.size();
+	for (int k = 0; k < C; k++)
+	{
+		int c = order_[k];
+		int Nin = nl.numInputs(c);
+		int Nout = nl.numOutputs(c);
+		int p0 = nl.firstInput(c);
+		int q0 = nl.firstOutput(c);
+
+		for (int i = 0; i < Nin; i++)
+		{
+			int n = nl.inputNet(p0+i);
+			in_[i] = (n < 0) ? Bit64() : value_[n];
+		}
+		for (int o = 0; o < Nout; o++)
+			out_[o] = value_[nl.outputNet(q0+o)];
+
+		nl.cell(c)->evaluate64(&in_[0], &out_[0]);
+
+		for (int o = 0; o < Nout; o++)
+			value_[nl.outputNet(q0+o)] = out_[o];
+	}
+}
+
+int PatternSim::portNet(const Port& p, int i) const
+{
+	assert(i >= 0 && i < p.width());
+	return p.isOutput ? topOut_[p.low+i] : topIn_[p.low+i];
+}
+
+Bit64 PatternSim::get(const std::string& name, int i) const
+{
+	int n = portNet(net_.top()->port(name), i);
+	return (n < 0) ? Bit64() : value_[n];
+}
+
+void PatternSim::set(const std::string& name, int i, Bit64 b)
+{
+	const Port& p = net_.top()->port(name);
+	assert(!p.isOutput);
+	int n = portNet(p, i);
+	if (n >= 0) value_[n] = b;
+}
+
+void PatternSim::setRandom(const std::string& name)
+{
+	int N = net_.top()->port(name).width();
+	for (int i = 0; i < N; i++)
+		set(name, i, Bit64::random());
+}
+
+BitVector PatternSim::getVector(const std::string& name, int k) const
+{
+	int N = net_.top()->port(name).width();
+	BitVector vec(N);
+	for (int i = 0; i < N; i++)
+		vec.set(i, get(name, i).get(k));
+	return vec;
+}
+
+void PatternSim::setVector(const std::string& name, int k, const BitVector& vec)
+{
+	int N = net_.top()->port(name).width();
+	assert(N == vec.width());
+	for (int i = 0; i < N; i++)
+	{
+		Bit64 b = get(name, i);
+		b.set(k, vec.get(i));
+		set(name, i, b);
+	}
+}
+
+value_t PatternSim::getValue(const std::string& name, int k) const
+{
+	int N = net_.top()->port(name).width();
+	assert(N <= VALUE_T_BITS);
+	value_t val = 0;
+	for (int i = 0; i < N; i++)
+	{
+		Bit b = get(name, i).get(k);
+		assert(b.isDefined());
+		if (b == Bit(HIGH)) val |= (value_t)1 << i;
+	}
+	return val;
+}
+
+void PatternSim::setValue(const std::string& name, int k, value_t val)
+{
+	int N = net_.top()->port(name).width();
+	assert(N <= VALUE_T_BITS);
+	for (int i = 0; i < N; i++, val >>= 1)
+	{
+		Bit64 b = get(name, i);
+		b.set(k, Bit((val & 1) ? HIGH : LOW));
+		set(name, i, b);
+	}
+}
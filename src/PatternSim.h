@@ -0,0 +1,72 @@
+#ifndef PATTERNSIM_H_
+#define PATTERNSIM_H_
+
+#include <vector>
+#include <string>
+#include "Netlist.h"
+#include "Bit64.h"
+
+// Functional simulation of 64 input patterns at once.
+// The cells of a Netlist are sorted by level (each cell comes after the cells
+// that drive its inputs), and every cell is evaluated once for all 64 patterns
+// with Module::evaluate64(). Each net holds one Bit64 (value and defined words).
+// There is no queue, no history and no delays: only the final values of
+// combinational logic are computed. Cells in loops are evaluated once, in no
+// particular order (see hasLoops()).
+//
+// Inputs and outputs are the ports of the flattened (top) module.
+// The wires of the modules are not changed.
+class PatternSim
+{
+private:
+	const Netlist& net_;
+	// cells in level order, and the level of each cell
+	std::vector<int> order_;
+	std::vector<int> level_;
+	int Nlevels_;
+	bool loops_;
+
+	// value of each net
+	std::vector<Bit64> value_;
+	// net of each top-level input/output (-1 if none)
+	std::vector<int> topIn_;
+	std::vector<int> topOut_;
+
+	// scratch space for one cell
+	std::vector<Bit64> in_;
+	std::vector<Bit64> out_;
+
+	PatternSim(const PatternSim&);
+	PatternSim& operator=(const PatternSim&);
+
+	// net of top-level port bit i
+	int portNet(const Port& p, int i) const;
+
+public:
+	PatternSim(const Netlist& net);
+
+	// set all nets to the current values of their wires
+	void reset();
+
+	// evaluate all cells in level order
+	void simulate();
+
+	// get/set all 64 patterns of a top-level input/output bit
+	Bit64 get(const std::string& name, int i=0) const;
+	void set(const std::string& name, int i, Bit64 b);
+	// set every pattern of a top-level input to random values
+	void setRandom(const std::string& name);
+
+	// get/set pattern k of a top-level input/output
+	BitVector getVector(const std::string& name, int k) const;
+	void setVector(const std::string& name, int k, const BitVector& vec);
+	value_t getValue(const std::string& name, int k) const;
+	void setValue(const std::string& name, int k, value_t val);
+
+	// levelization info
+	int numLevels() const { return Nlevels_; }
+	int level(int c) const { return level_[c]; }
+	bool hasLoops() const { return loops_; }
+};
+
+#endif // PATTERNSIM_H_
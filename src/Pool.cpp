@@ -0,0 +1,71 @@
+#include <cassert>
+#include <stdint.h>
+#include "Pool.h"
+
+// a free block (the first bytes of an unused block)
+struct PoolBlock
+{
+	PoolBlock* next;
+};
+
+static const int NCLASSES = Pool::MAX_SIZE / Pool::GRAIN;
+
+// free lists of this thread, one per size class
+static __thread PoolBlock* freeList[NCLASSES];
+
+// bytes in chunks (updated atomically)
+static size_t reservedBytes = 0;
+
+// carve a new chunk into blocks of class c
+static void refill(int c)
+{
+	size_t size = (c+1) * Pool::GRAIN;
+	char* chunk = static_cast<char*>(::operator new(Pool::CHUNK));
+	__sync_fetch_and_add(&reservedBytes, Pool::CHUNK);
+
+	size_t N = Pool::CHUNK / size;
+	PoolBlock* head = freeList[c];
+	for (size_t k = N; k > 0; k--)
+	{
+		// link in reverse, so blocks are handed out in address order
+		PoolBlock* b = reinterpret_cast<PoolBlock*>(chunk + (k-1)*size);
+		b->next = head;
+		head = b;
+	}
+	freeList[c] = head;
+}
+
+void* Pool::alloc(size_t n)
+{
+	if (n == 0) n = 1;
+	if (n > MAX_SIZE)
+		return ::operator new(n);
+
+	int c = (n-1) / GRAIN;
+	if (!freeList[c])
+		refill(c);
+	PoolBlock* b = freeList[c];
+	freeList[c] = b->next;
+	return b;
+}
+
+void Pool::free(void* p, size_t n)
+{
+	if (!p) return;
+	if (n == 0) n = 1;
+	if (n > MAX_SIZE)
+	{
+		::operator delete(p);
+		return;
+	}
+
+	int c = (n-1) / GRAIN;
+	PoolBlock* b = static_cast<PoolBlock*>(p);
+	b->next = freeList[c];
+	freeList[c] = b;
+}
+
+size_t Pool::reserved()
+{
+	return __sync_fetch_and_add(&reservedBytes, 0);
+}
@@ -0,0 +1,69 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <cstddef>
+#include <new>
+
+// Small-object allocator for the many little objects of a design
+// (modules, wires, reader sets).
+// Sizes are rounded up to a multiple of GRAIN, and each size class has its own
+// free list, carved out of CHUNK-byte chunks. Objects of the same class that are
+// built together end up next to each other in memory.
+// Each thread has its own free lists, so no locking is needed; a block may be
+// freed on a different thread than the one that allocated it.
+// Chunks are kept for reuse and never returned to the system.
+// Sizes above MAX_SIZE use the global operator new.
+class Pool
+{
+public:
+	static const size_t GRAIN = 16;
+	static const size_t MAX_SIZE = 512;
+	static const size_t CHUNK = 65536;
+
+	// allocate/free n bytes (free must get the same n)
+	static void* alloc(size_t n);
+	static void free(void* p, size_t n);
+
+	// total bytes in chunks (all threads)
+	static size_t reserved();
+};
+
+// std allocator on the Pool (for containers)
+template<class T>
+class PoolAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template<class U> struct rebind { typedef PoolAllocator<U> other; };
+
+	PoolAllocator() {}
+	template<class U> PoolAllocator(const PoolAllocator<U>&) {}
+
+	pointer address(reference x) const { return &x; }
+	const_pointer address(const_reference x) const { return &x; }
+	size_type max_size() const { return size_t(-1) / sizeof(T); }
+
+	pointer allocate(size_type n, const void* = 0)
+	{
+		return static_cast<pointer>(Pool::alloc(n*sizeof(T)));
+	}
+	void deallocate(pointer p, size_type n)
+	{
+		Pool::free(p, n*sizeof(T));
+	}
+
+	void construct(pointer p, const T& val) { new(p) T(val); }
+	void destroy(pointer p) { p->~T(); }
+
+	template<class U> bool operator==(const PoolAllocator<U>&) const { return true; }
+	template<class U> bool operator!=(const PoolAllocator<U>&) const { return false; }
+};
+
+#endif // POOL_H_
@@ -0,0 +1,661 @@
+#include <map>
+#include <algorithm>
+#include "PowerEstimate.h"
+#include "Wire.h"
+#include "param.h"
+
+// truth tables are read for outputs with up to this many inputs, and
+// wider outputs are estimated from this many random samples
+#define MAX_TABLE_INPUTS 8
+#define WIDE_SAMPLES 1024
+// smaller densities at one time are dropped
+#define MIN_DENSITY 1e-9
+
+// inputs at position j < 6 of a truth table get the lanes with bit j set,
+// and the others are the same on all lanes of batch b (bit j-6 of b)
+static const uint64_t LANES[6] = {
+	0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+	0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+};
+
+static inline Bit64 lanePattern(int j, int b)
+{
+	if (j < 6) return Bit64(LANES[j], ~(uint64_t)0);
+	return Bit64(((b >> (j - 6)) & 1) ? HIGH : LOW);
+}
+
+PowerEstimate::PowerEstimate(const Netlist& net) :
+	 net_(net)
+	,energy_(0)
+	,exact_(0)
+	,numExact_(0)
+	,in_(std::max(net.maxInputs(),1))
+	,out_(std::max(net.maxOutputs(),1))
+	,flip_(std::max(net.maxOutputs(),1))
+	,value_(net.numNets())
+	,mark_(net.numNets(), 0)
+	,cellMark_(net.numCells(), 0)
+	,stamp_(0)
+	,seed_(1)
+{
+	net_.levelize(order_, level_, loops_);
+	pos_.assign(net_.numCells(), 0);
+	for (int k = 0; k < (int)order_.size(); k++)
+		pos_[order_[k]] = k;
+
+	// writer of each net
+	writer_.assign(net_.numNets(), -1);
+	writerOut_.assign(net_.numNets(), -1);
+	for (int c = 0; c < net_.numCells(); c++)
+		for (int o = 0; o < net_.numOutputs(c); o++)
+		{
+			int n = net_.outputNet(net_.firstOutput(c) + o);
+			writer_[n] = c;
+			writerOut_[n] = o;
+		}
+
+	// find the nets of the top-level inputs
+	std::map<const Wire*,int> netmap;
+	for (int n = 0; n < net_.numNets(); n++)
+		netmap[net_.net(n)] = n;
+
+	Module* top = net_.top();
+	topIn_.assign(top->numInputs(), -1);
+	for (int i = 0; i < top->numInputs(); i++)
+	{
+		std::map<const Wire*,int>::iterator iter = netmap.find(top->inputWire(i));
+		if (iter != netmap.end()) topIn_[i] = (*iter).second;
+	}
+
+	inProb_.assign(top->numInputs(), 0.5);
+	inDensity_.assign(top->numInputs(), 0.5);
+}
+
+void PowerEstimate::setInput(int i, double prob, double density)
+{
+	assert(i >= 0 && i < (int)inProb_.size());
+	assert(prob >= 0 && prob <= 1 && density >= 0 && density <= 1);
+	inProb_[i] = prob;
+	inDensity_[i] = density;
+}
+
+void PowerEstimate::setInputs(double prob, double density)
+{
+	for (int i = 0; i < (int)inProb_.size(); i++)
+		setInput(i, prob, density);
+}
+
+void PowerEstimate::useExact(int N)
+{
+	assert(N >= 0 && N <= 20);
+	exact_ = N;
+}
+
+void PowerEstimate::estimate()
+{
+	int N = net_.numNets();
+
+	// nets without a writer keep their current value
+	prob_.assign(N, 0);
+	density_.assign(N, 0);
+	events_.assign(N, std::vector<EVENT_T>());
+	for (int n = 0; n < N; n++)
+	{
+		Bit b = net_.net(n)->get();
+		value_[n] = Bit64(b);
+		if (b == Bit(HIGH)) prob_[n] = 1;
+	}
+	for (int i = 0; i < (int)topIn_.size(); i++)
+	{
+		int n = topIn_[i];
+		if (n < 0) continue;
+		prob_[n] = inProb_[i];
+		density_[n] = inDensity_[i];
+		if (inDensity_[i] > 0)
+			events_[n].push_back(EVENT_T(0, inDensity_[i]));
+	}
+
+	// each top-level input depends on itself
+	if (exact_ > 0)
+	{
+		support_.assign(N, std::vector<int>());
+		wide_.assign(N, 0);
+		for (int i = 0; i < (int)topIn_.size(); i++)
+			if (topIn_[i] >= 0) support_[topIn_[i]].push_back(i);
+	}
+
+	numExact_ = 0;
+	energy_ = 0;
+	seed_ = 1;
+	for (int k = 0; k < (int)order_.size(); k++)
+	{
+		int c = order_[k];
+		cellSupport(c);
+		if (exact_ > 0 && !loops_)
+		{
+			propagateSupport(c);
+			if (exactCell(c))
+				numExact_++;
+			else
+				estimateCell(c);
+		}
+		else
+			estimateCell(c);
+
+		// every new output value costs its energy
+		Module* m = net_.cell(c);
+		int q0 = net_.firstOutput(c);
+		for (int o = 0; o < net_.numOutputs(c); o++)
+			energy_ += m->energy(o) * density_[net_.outputNet(q0+o)];
+	}
+}
+
+void PowerEstimate::cellSupport(int c)
+{
+	int Nout = net_.numOutputs(c);
+	if ((int)outSup_.size() < Nout)
+	{
+		outSup_.resize(Nout);
+		outDelay_.resize(Nout);
+	}
+	for (int o = 0; o < Nout; o++)
+	{
+		outSup_[o].clear();
+		outDelay_[o].clear();
+	}
+
+	int p0 = net_.firstInput(c);
+	int q0 = net_.firstOutput(c);
+	for (int i = 0; i < net_.numInputs(c); i++)
+		for (int a = net_.firstArc(p0+i); a < net_.endArc(p0+i); a++)
+		{
+			int o = net_.arcOutput(a);
+			delay_t d = net_.arcDelay(a);
+#if USE_FANOUT_DELAY
+			d += net_.outputFanout(q0+o);
+#endif
+			outSup_[o].push_back(i);
+			outDelay_[o].push_back(d);
+		}
+}
+
+void PowerEstimate::tableActivity(int c, int o, const std::vector<char>& table)
+{
+	const std::vector<int>& sup = outSup_[o];
+	int k = sup.size();
+	int M = 1 << k;
+	int p0 = net_.firstInput(c);
+
+	// probability of each minterm
+	std::vector<double> w(M, 1.0);
+	for (int j = 0; j < k; j++)
+	{
+		int n = net_.inputNet(p0 + sup[j]);
+		double p = (n < 0) ? 0 : prob_[n];
+		int bit = 1 << j;
+		for (int m = 0; m < bit; m++)
+		{
+			w[m | bit] = w[m] * p;
+			w[m] *= 1 - p;
+		}
+	}
+
+	double P = 0;
+	for (int m = 0; m < M; m++)
+		if (table[m]) P += w[m];
+
+	// the minterms where changing the inputs in s changes the output
+	std::vector<double> Q(M, 0);
+	for (int s = 1; s < M; s++)
+		for (int m = 0; m < M; m++)
+			if (table[m] != table[m ^ s]) Q[s] += w[m];
+	outputActivity(c, o, P, Q);
+}
+
+// a change of input j of a cell output at time T
+struct InputEvent
+{
+	delay_t T;
+	int j;
+	double d;
+	InputEvent(delay_t t, int jj, double dd) : T(t), j(jj), d(dd) {}
+	bool operator<(const InputEvent& other) const
+	{
+		if (T != other.T) return T < other.T;
+		return j < other.j;
+	}
+};
+
+void PowerEstimate::outputActivity(int c, int o, double P, const std::vector<double>& Q)
+{
+	const std::vector<int>& sup = outSup_[o];
+	const std::vector<delay_t>& dly = outDelay_[o];
+	int k = sup.size();
+	int p0 = net_.firstInput(c);
+
+	// changes of the inputs, in time order
+	std::vector<InputEvent> in;
+	for (int j = 0; j < k; j++)
+	{
+		int n = net_.inputNet(p0 + sup[j]);
+		if (n < 0) continue;
+		for (int e = 0; e < (int)events_[n].size(); e++)
+			in.push_back(InputEvent(events_[n][e].first, j, events_[n][e].second));
+	}
+	std::sort(in.begin(), in.end());
+
+	// every set of inputs that can change at the same time changes the
+	// output after the largest delay of the set
+	std::vector<EVENT_T> ev;
+	for (int e0 = 0, e1 = 0; e0 < (int)in.size(); e0 = e1)
+	{
+		while (e1 < (int)in.size() && in[e1].T == in[e0].T) e1++;
+		int A = e1 - e0;
+		for (int s = 1; s < (1 << A); s++)
+		{
+			double p = 1;
+			int mask = 0;
+			delay_t d = DELAY_T_MIN;
+			for (int a = 0; a < A; a++)
+			{
+				const InputEvent& x = in[e0 + a];
+				if ((s >> a) & 1)
+				{
+					p *= x.d;
+					mask |= 1 << x.j;
+					d = std::max(d, dly[x.j]);
+				}
+				else
+					p *= 1 - x.d;
+			}
+			if (Q[mask] > 0 && p > 0)
+				ev.push_back(EVENT_T(in[e0].T + d, p * Q[mask]));
+		}
+	}
+
+	setEvents(net_.outputNet(net_.firstOutput(c) + o), P, ev);
+}
+
+void PowerEstimate::setEvents(int n, double P, std::vector<EVENT_T>& ev)
+{
+	// at most one change at each time
+	std::sort(ev.begin(), ev.end());
+	std::vector<EVENT_T>& out = events_[n];
+	out.clear();
+	double D = 0;
+	for (int e0 = 0, e1 = 0; e0 < (int)ev.size(); e0 = e1)
+	{
+		double d = 0;
+		for (; e1 < (int)ev.size() && ev[e1].first == ev[e0].first; e1++)
+			d += ev[e1].second;
+		d = std::min(d, 1.0);
+		if (d < MIN_DENSITY) continue;
+		out.push_back(EVENT_T(ev[e0].first, d));
+		D += d;
+	}
+	prob_[n] = P;
+	density_[n] = D;
+}
+
+uint64_t PowerEstimate::randomLanes(double p)
+{
+	// each bit of p (16 of them, the last one first) ORs in or ANDs with
+	// random lanes, so every lane is HIGH with probability p
+	uint64_t bits = (uint64_t)(p * 65536 + 0.5);
+	if (bits >= 65536) return ~(uint64_t)0;
+	uint64_t lanes = 0;
+	for (int k = 0; k < 16; k++, bits >>= 1)
+	{
+		// xorshift64
+		seed_ ^= seed_ << 13;
+		seed_ ^= seed_ >> 7;
+		seed_ ^= seed_ << 17;
+		lanes = (bits & 1) ? (lanes | seed_) : (lanes & seed_);
+	}
+	return lanes;
+}
+
+void PowerEstimate::sampleActivity(int c, int o)
+{
+	Module* m = net_.cell(c);
+	const std::vector<int>& sup = outSup_[o];
+	const std::vector<delay_t>& dly = outDelay_[o];
+	int k = sup.size();
+	int Nin = net_.numInputs(c);
+	int Nout = net_.numOutputs(c);
+	int p0 = net_.firstInput(c);
+	const int batches = WIDE_SAMPLES / 64;
+	const double share = 1.0 / WIDE_SAMPLES;
+
+	// changes of the inputs, in time order
+	std::vector<InputEvent> in;
+	for (int j = 0; j < k; j++)
+	{
+		int n = net_.inputNet(p0 + sup[j]);
+		if (n < 0) continue;
+		for (int e = 0; e < (int)events_[n].size(); e++)
+			in.push_back(InputEvent(events_[n][e].first, j, events_[n][e].second));
+	}
+	std::sort(in.begin(), in.end());
+
+	// every sample has random inputs, and a random set of the inputs that
+	// can change at each time (the output changes after their largest delay)
+	std::vector<uint64_t> x(k), flips;
+	std::vector<EVENT_T> ev;
+	double P = 0;
+	for (int b = 0; b < batches; b++)
+	{
+		for (int i = 0; i < Nin; i++)
+			in_[i] = Bit64(LOW);
+		for (int j = 0; j < k; j++)
+		{
+			int n = net_.inputNet(p0 + sup[j]);
+			x[j] = randomLanes((n < 0) ? 0 : prob_[n]);
+			in_[sup[j]] = Bit64(x[j], ~(uint64_t)0);
+		}
+		for (int o2 = 0; o2 < Nout; o2++)
+			out_[o2] = Bit64();
+		m->evaluate64(&in_[0], &out_[0]);
+		uint64_t y = out_[o].high();
+		P += __builtin_popcountll(y) * share;
+
+		for (int e0 = 0, e1 = 0; e0 < (int)in.size(); e0 = e1)
+		{
+			while (e1 < (int)in.size() && in[e1].T == in[e0].T) e1++;
+			flips.assign(e1 - e0, 0);
+			for (int e = e0; e < e1; e++)
+			{
+				flips[e - e0] = randomLanes(in[e].d);
+				in_[sup[in[e].j]] = Bit64(x[in[e].j] ^ flips[e - e0], ~(uint64_t)0);
+			}
+			for (int o2 = 0; o2 < Nout; o2++)
+				flip_[o2] = Bit64();
+			m->evaluate64(&in_[0], &flip_[0]);
+			for (int e = e0; e < e1; e++)
+				in_[sup[in[e].j]] = Bit64(x[in[e].j], ~(uint64_t)0);
+
+			uint64_t diff = y ^ flip_[o].high();
+			for (int l = 0; diff; l++, diff >>= 1)
+			{
+				if (!(diff & 1)) continue;
+				delay_t d = DELAY_T_MIN;
+				for (int e = e0; e < e1; e++)
+					if ((flips[e - e0] >> l) & 1) d = std::max(d, dly[in[e].j]);
+				ev.push_back(EVENT_T(in[e0].T + d, share));
+			}
+		}
+	}
+	setEvents(net_.outputNet(net_.firstOutput(c) + o), P, ev);
+}
+
+void PowerEstimate::estimateCell(int c)
+{
+	Module* m = net_.cell(c);
+	int Nin = net_.numInputs(c);
+	int Nout = net_.numOutputs(c);
+
+	std::vector<int> left, next;
+	for (int o = 0; o < Nout; o++)
+	{
+		int k = outSup_[o].size();
+		if (k == 0) continue;
+		if (k <= MAX_TABLE_INPUTS)
+		{
+			left.push_back(o);
+			continue;
+		}
+
+		// too wide for a truth table
+		sampleActivity(c, o);
+	}
+
+	// input j of an output gets position j in its truth table, so the outputs
+	// whose inputs agree on their positions are read from the same evaluations
+	std::vector<int> pos(Nin);
+	std::vector<int> round;
+	std::vector< std::vector<char> > tables(Nout);
+	while (!left.empty())
+	{
+		std::fill(pos.begin(), pos.end(), -1);
+		round.clear();
+		next.clear();
+		int K = 0;
+		for (int r = 0; r < (int)left.size(); r++)
+		{
+			int o = left[r];
+			const std::vector<int>& sup = outSup_[o];
+			int k = sup.size();
+
+			// outputs of more than 6 inputs need batches on their own
+			bool fits = (K <= 6 && k <= 6) || round.empty();
+			for (int j = 0; fits && j < k; j++)
+				if (pos[sup[j]] >= 0 && pos[sup[j]] != j) fits = false;
+			if (!fits)
+			{
+				next.push_back(o);
+				continue;
+			}
+			for (int j = 0; j < k; j++)
+				pos[sup[j]] = j;
+			round.push_back(o);
+			K = std::max(K, k);
+		}
+
+		int batches = (K > 6) ? 1 << (K - 6) : 1;
+		for (int r = 0; r < (int)round.size(); r++)
+			tables[round[r]].assign(1 << outSup_[round[r]].size(), 0);
+		for (int b = 0; b < batches; b++)
+		{
+			for (int i = 0; i < Nin; i++)
+				in_[i] = (pos[i] < 0) ? Bit64(LOW) : lanePattern(pos[i], b);
+			for (int o = 0; o < Nout; o++)
+				out_[o] = Bit64();
+			m->evaluate64(&in_[0], &out_[0]);
+
+			for (int r = 0; r < (int)round.size(); r++)
+			{
+				int o = round[r];
+				std::vector<char>& table = tables[o];
+				int M = std::min((int)table.size(), 64);
+				for (int l = 0; l < M; l++)
+					table[b*64 + l] = (out_[o].high() >> l) & 1;
+			}
+		}
+
+		for (int r = 0; r < (int)round.size(); r++)
+			tableActivity(c, round[r], tables[round[r]]);
+		left.swap(next);
+	}
+}
+
+void PowerEstimate::propagateSupport(int c)
+{
+	int p0 = net_.firstInput(c);
+	int q0 = net_.firstOutput(c);
+	std::vector<int> merged;
+	for (int o = 0; o < net_.numOutputs(c); o++)
+	{
+		int n = net_.outputNet(q0 + o);
+		std::vector<int>& sup = support_[n];
+		sup.clear();
+		wide_[n] = 0;
+		for (int j = 0; j < (int)outSup_[o].size() && !wide_[n]; j++)
+		{
+			int n2 = net_.inputNet(p0 + outSup_[o][j]);
+			if (n2 < 0) continue;
+			if (wide_[n2])
+			{
+				wide_[n] = 1;
+				break;
+			}
+			merged.clear();
+			std::set_union(sup.begin(), sup.end(), support_[n2].begin(), support_[n2].end(),
+			               std::back_inserter(merged));
+			sup.swap(merged);
+			if ((int)sup.size() > exact_) wide_[n] = 1;
+		}
+		if (wide_[n]) sup.clear();
+	}
+}
+
+void PowerEstimate::evaluateCell(int c)
+{
+	int p0 = net_.firstInput(c);
+	int q0 = net_.firstOutput(c);
+	for (int i = 0; i < net_.numInputs(c); i++)
+	{
+		int n = net_.inputNet(p0 + i);
+		in_[i] = (n < 0) ? Bit64(LOW) : value_[n];
+	}
+	for (int o = 0; o < net_.numOutputs(c); o++)
+		out_[o] = value_[net_.outputNet(q0 + o)];
+	net_.cell(c)->evaluate64(&in_[0], &out_[0]);
+}
+
+bool PowerEstimate::exactCell(int c)
+{
+	int Nin = net_.numInputs(c);
+	int Nout = net_.numOutputs(c);
+	int p0 = net_.firstInput(c);
+	int q0 = net_.firstOutput(c);
+
+	// the inputs that reach an output (at most MAX_TABLE_INPUTS),
+	// and their top-level inputs
+	std::vector<int> pos(Nout * Nin, -1);
+	std::vector<int> used;
+	for (int o = 0; o < Nout; o++)
+		for (int j = 0; j < (int)outSup_[o].size(); j++)
+		{
+			int i = outSup_[o][j];
+			pos[o*Nin + i] = j;
+			if (std::find(used.begin(), used.end(), i) == used.end())
+				used.push_back(i);
+		}
+	int U = used.size();
+	if (U == 0 || U > MAX_TABLE_INPUTS) return false;
+
+	std::vector<int> S, merged;
+	int total = 0;
+	for (int u = 0; u < U; u++)
+	{
+		int n = net_.inputNet(p0 + used[u]);
+		if (n < 0) continue;
+		if (wide_[n]) return false;
+		total += support_[n].size();
+		merged.clear();
+		std::set_union(S.begin(), S.end(), support_[n].begin(), support_[n].end(),
+		               std::back_inserter(merged));
+		S.swap(merged);
+		if ((int)S.size() > exact_) return false;
+	}
+	// inputs that share no top-level inputs are independent already
+	if (total == (int)S.size()) return false;
+
+	// the cone: cells that the used inputs depend on, in level order
+	// (only through the inputs of the outputs on the way)
+	std::vector<int> nets, cone;
+	stamp_++;
+	for (int u = 0; u < U; u++)
+	{
+		int n = net_.inputNet(p0 + used[u]);
+		if (n >= 0 && mark_[n] != stamp_)
+		{
+			mark_[n] = stamp_;
+			nets.push_back(n);
+		}
+	}
+	for (int k = 0; k < (int)nets.size(); k++)
+	{
+		int c2 = writer_[nets[k]];
+		if (c2 < 0) continue;
+		if (cellMark_[c2] != stamp_)
+		{
+			cellMark_[c2] = stamp_;
+			cone.push_back(c2);
+		}
+		int p2 = net_.firstInput(c2);
+		for (int i = 0; i < net_.numInputs(c2); i++)
+		{
+			int n = net_.inputNet(p2 + i);
+			if (n < 0 || mark_[n] == stamp_) continue;
+			for (int a = net_.firstArc(p2 + i); a < net_.endArc(p2 + i); a++)
+				if (net_.arcOutput(a) == writerOut_[nets[k]])
+				{
+					mark_[n] = stamp_;
+					nets.push_back(n);
+					break;
+				}
+		}
+	}
+	std::vector< std::pair<int,int> > sorted;
+	for (int k = 0; k < (int)cone.size(); k++)
+		sorted.push_back(std::make_pair(pos_[cone[k]], cone[k]));
+	std::sort(sorted.begin(), sorted.end());
+
+	// every combination of the top-level inputs, with its probability
+	int s = S.size();
+	int batches = (s > 6) ? 1 << (s - 6) : 1;
+	int lanes = (s < 6) ? 1 << s : 64;
+	std::vector<double> P(Nout, 0);
+	std::vector< std::vector<double> > Q(Nout);
+	for (int o = 0; o < Nout; o++)
+		Q[o].assign(1 << outSup_[o].size(), 0);
+	double w[64];
+	for (int b = 0; b < batches; b++)
+	{
+		for (int j = 0; j < s; j++)
+			value_[topIn_[S[j]]] = lanePattern(j, b);
+		for (int l = 0; l < 64; l++)
+		{
+			w[l] = (l < lanes) ? 1.0 : 0.0;
+			int m = b*64 + l;
+			for (int j = 0; j < s && l < lanes; j++)
+				w[l] *= ((m >> j) & 1) ? inProb_[S[j]] : 1 - inProb_[S[j]];
+		}
+
+		for (int k = 0; k < (int)sorted.size(); k++)
+		{
+			int c2 = sorted[k].second;
+			evaluateCell(c2);
+			int q2 = net_.firstOutput(c2);
+			for (int o = 0; o < net_.numOutputs(c2); o++)
+				value_[net_.outputNet(q2 + o)] = out_[o];
+		}
+
+		// the outputs, and the lanes where changing a set of inputs changes them
+		evaluateCell(c);
+		for (int o = 0; o < Nout; o++)
+			for (int l = 0; l < 64; l++)
+				if ((out_[o].high() >> l) & 1) P[o] += w[l];
+		for (int set = 1; set < (1 << U); set++)
+		{
+			for (int u = 0; u < U; u++)
+				if ((set >> u) & 1)
+					in_[used[u]] = Bit64(~in_[used[u]].val, in_[used[u]].def);
+			for (int o = 0; o < Nout; o++)
+				flip_[o] = value_[net_.outputNet(q0 + o)];
+			net_.cell(c)->evaluate64(&in_[0], &flip_[0]);
+			for (int u = 0; u < U; u++)
+				if ((set >> u) & 1)
+					in_[used[u]] = Bit64(~in_[used[u]].val, in_[used[u]].def);
+
+			for (int o = 0; o < Nout; o++)
+			{
+				// only the sets of the output's own inputs
+				int mask = 0;
+				for (int u = 0; u < U && mask >= 0; u++)
+					if ((set >> u) & 1)
+						mask = (pos[o*Nin + used[u]] < 0) ? -1 : mask | (1 << pos[o*Nin + used[u]]);
+				if (mask <= 0) continue;
+				uint64_t diff = out_[o].high() ^ flip_[o].high();
+				for (int l = 0; diff; l++, diff >>= 1)
+					if (diff & 1) Q[o][mask] += w[l];
+			}
+		}
+	}
+
+	for (int o = 0; o < Nout; o++)
+		if (!outSup_[o].empty())
+			outputActivity(c, o, P[o], Q[o]);
+	return true;
+}
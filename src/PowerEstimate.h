@@ -0,0 +1,136 @@
+#ifndef POWERESTIMATE_H_
+#define POWERESTIMATE_H_
+
+#include <vector>
+#include <utility>
+#include "Netlist.h"
+#include "Bit64.h"
+
+// Power estimate of a Netlist without simulation.
+// Every net gets a signal probability (of being HIGH) and a transition
+// density (expected number of new values per cycle), propagated from the
+// top-level inputs through the cells in level order. The densities are kept
+// per time step after the start of the cycle, with the delays of
+// simulation, so glitches are counted as in Module::simulate():
+//   P(y) = sum of the input probabilities over the minterms of y
+//   D(y,T) = sum over sets S of inputs that change at the same time t of
+//            P(all of S change at t) * P(y changes when S changes)
+// where T is t plus the largest delay from S to y (and its fanout). An input
+// set of one input gives the usual boolean difference P(dy/dx) * D(x,t).
+// The truth table of every cell output is read with Module::evaluate64() over
+// its inputs (the ones with a delay to it), so any leaf module works, and
+// the inputs of a cell are taken to be independent (outputs with more than
+// a few inputs are sampled instead). The average energy per cycle is the sum
+// of energy(o) * D(o) over all cell outputs, in one pass.
+//
+// Signals that reconverge are not independent. With useExact(N), cells
+// whose correlated inputs depend on at most N top-level inputs get exact
+// probabilities instead, by evaluating their whole fan-in cone for every
+// combination of those top-level inputs.
+//
+// Top-level inputs change at time 0 (at most once per cycle). Cells in loops
+// are visited once, in no particular order.
+class PowerEstimate
+{
+private:
+	const Netlist& net_;
+	// cells in level order, and the position of each cell in it
+	std::vector<int> order_;
+	std::vector<int> level_;
+	std::vector<int> pos_;
+	bool loops_;
+
+	// net of each top-level input (-1 if none), and the cell (and its output)
+	// that writes each net
+	std::vector<int> topIn_;
+	std::vector<int> writer_;
+	std::vector<int> writerOut_;
+	// probability and density of each top-level input
+	std::vector<double> inProb_;
+	std::vector<double> inDensity_;
+
+	// probability and density of each net, and its density at each time
+	// (the times it can change, in order)
+	typedef std::pair<delay_t,double> EVENT_T;
+	std::vector<double> prob_;
+	std::vector<double> density_;
+	std::vector< std::vector<EVENT_T> > events_;
+	double energy_;
+
+	// cones with at most exact_ top-level inputs are exact (0 for none)
+	int exact_;
+	int numExact_;
+	// top-level inputs each net depends on (empty if more than exact_),
+	// and whether there are too many
+	std::vector< std::vector<int> > support_;
+	std::vector<char> wide_;
+
+	// scratch space: inputs of each output of a cell (the ones with a delay
+	// to it) and their delays, cell inputs/outputs, net values and visited
+	// nets/cells of a cone
+	std::vector< std::vector<int> > outSup_;
+	std::vector< std::vector<delay_t> > outDelay_;
+	std::vector<Bit64> in_;
+	std::vector<Bit64> out_;
+	std::vector<Bit64> flip_;
+	std::vector<Bit64> value_;
+	std::vector<int> mark_;
+	std::vector<int> cellMark_;
+	int stamp_;
+	// random samples (the same for every estimate)
+	uint64_t seed_;
+
+	PowerEstimate(const PowerEstimate&);
+	PowerEstimate& operator=(const PowerEstimate&);
+
+	// find the inputs of each output of cell c
+	void cellSupport(int c);
+	// probability and changes of output o of cell c from its truth table
+	// (inputs in outSup_[o], minterm m has input outSup_[o][j] at bit j)
+	void tableActivity(int c, int o, const std::vector<char>& table);
+	// set the probability P of output o of cell c, and its density from
+	// the probability Q[s] that it changes when the inputs in s change
+	void outputActivity(int c, int o, double P, const std::vector<double>& Q);
+	// same, from random samples (for outputs with many inputs)
+	void sampleActivity(int c, int o);
+	// set the probability and the changes (in any order) of net n
+	void setEvents(int n, double P, std::vector<EVENT_T>& ev);
+	// 64 random lanes that are HIGH with probability p
+	uint64_t randomLanes(double p);
+	// estimate the outputs of cell c with independent inputs
+	void estimateCell(int c);
+	// estimate the outputs of cell c from its cone (false if too wide)
+	bool exactCell(int c);
+	// top-level inputs of the outputs of cell c
+	void propagateSupport(int c);
+	// evaluate cell c on the scratch net values (into in_ and out_)
+	void evaluateCell(int c);
+
+public:
+	PowerEstimate(const Netlist& net);
+
+	// probability and density of top-level input i (or all of them)
+	// (the default is 0.5 and 0.5: independent random vectors)
+	void setInput(int i, double prob, double density);
+	void setInputs(double prob, double density);
+
+	// use exact cones of up to N top-level inputs (0 turns it off)
+	void useExact(int N);
+
+	// propagate the probabilities and densities, and sum the energy
+	void estimate();
+
+	// per-net results
+	inline double probability(int n) const { return prob_[n]; }
+	inline double density(int n) const { return density_[n]; }
+
+	// average energy per cycle, and average power at a clock period
+	inline double energy() const { return energy_; }
+	inline double power(delay_t period) const { return energy_ / period; }
+
+	// number of cells estimated from exact cones
+	inline int numExact() const { return numExact_; }
+	inline bool hasLoops() const { return loops_; }
+};
+
+#endif // POWERESTIMATE_H_
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <iomanip>
+#include "PowerReport.h"
+#include "SystemModule.h"
+
+// larger energy first (then by name, so the order is the same every run)
+static bool moreEnergy(const PowerEntry& a, const PowerEntry& b)
+{
+	if (a.energy != b.energy) return a.energy > b.energy;
+	return a.name < b.name;
+}
+
+unsigned long ActivityTable::toggles(const Module* m) const
+{
+	ACTMAP_T::const_iterator iter = table_.find(m);
+	return (iter == table_.end()) ? 0 : (*iter).second.toggles;
+}
+
+double ActivityTable::energy(const Module* m) const
+{
+	ACTMAP_T::const_iterator iter = table_.find(m);
+	return (iter == table_.end()) ? 0 : (*iter).second.energy;
+}
+
+PowerReport::PowerReport(Module& top, const ActivityTable& activity)
+{
+	CLASSMAP_T classes;
+	collect(&top, top.classname(), activity, root_, classes);
+
+	for (CLASSMAP_T::const_iterator iter = classes.begin(); iter != classes.end(); iter++)
+		classes_.push_back((*iter).second);
+	std::sort(classes_.begin(), classes_.end(), moreEnergy);
+}
+
+void PowerReport::collect(Module* m, const std::string& name, const ActivityTable& activity,
+                          PowerEntry& entry, CLASSMAP_T& classes)
+{
+	entry.name = name;
+	entry.count = 1;
+
+	if (!m->isSystem())
+	{
+		entry.toggles = activity.toggles(m);
+		entry.energy = activity.energy(m);
+
+		PowerEntry& c = classes[m->classname()];
+		c.name = m->classname();
+		c.count++;
+		c.toggles += entry.toggles;
+		c.energy += entry.energy;
+		return;
+	}
+
+	// group the submodules
+	SystemModule* sys = (SystemModule*)m;
+	std::map<Module*,const std::string*> groups;
+	for (size_t k = 0; k < sys->groups_.size(); k++)
+		groups[sys->groups_[k].first] = sys->groups_[k].second;
+	std::map<std::string,int> index;
+	for (MITER_T iter = sys->submodules_.begin(); iter != sys->submodules_.end(); iter++)
+	{
+		std::map<Module*,const std::string*>::const_iterator g = groups.find(*iter);
+		PowerEntry e;
+		collect(*iter, (g == groups.end()) ? (*iter)->classname() : *(*g).second,
+		        activity, e, classes);
+		entry.toggles += e.toggles;
+		entry.energy += e.energy;
+
+		std::map<std::string,int>::iterator found = index.find(e.name);
+		if (found == index.end())
+		{
+			index[e.name] = (int)entry.children.size();
+			entry.children.push_back(e);
+		}
+		else
+			merge(entry.children[(*found).second], e);
+	}
+	sort(entry.children);
+}
+
+void PowerReport::merge(PowerEntry& into, const PowerEntry& e)
+{
+	into.count += e.count;
+	into.toggles += e.toggles;
+	into.energy += e.energy;
+
+	// instances of the same system have the same groups
+	for (size_t k = 0; k < e.children.size(); k++)
+	{
+		size_t j = 0;
+		while (j < into.children.size() && into.children[j].name != e.children[k].name) j++;
+		if (j < into.children.size())
+			merge(into.children[j], e.children[k]);
+		else
+			into.children.push_back(e.children[k]);
+	}
+	sort(into.children);
+}
+
+void PowerReport::sort(std::vector<PowerEntry>& entries)
+{
+	std::sort(entries.begin(), entries.end(), moreEnergy);
+}
+
+void PowerReport::printEntry(std::ostream& out, const PowerEntry& e, int K, int depth, int indent) const
+{
+	double pct = (root_.energy > 0) ? 100.0 * e.energy / root_.energy : 0;
+	out << std::string(2*indent, ' ') << std::left << std::setw(40 - 2*indent) << e.name
+	    << std::right << std::setw(8) << e.count
+	    << std::setw(14) << e.energy
+	    << std::setw(8) << pct
+	    << std::setw(12) << e.toggles << std::endl;
+
+	if (indent + 1 >= depth) return;
+	int N = (int)e.children.size();
+	for (int k = 0; k < N && k < K; k++)
+		printEntry(out, e.children[k], K, depth, indent + 1);
+	if (N > K)
+		out << std::string(2*indent + 2, ' ') << "(" << N - K << " more)" << std::endl;
+}
+
+void PowerReport::print(std::ostream& out, int K, int depth) const
+{
+	std::ios::fmtflags flags = out.flags();
+	std::streamsize prec = out.precision();
+	out << std::fixed << std::setprecision(1);
+
+	out << std::left << std::setw(40) << "group" << std::right << std::setw(8) << "count"
+	    << std::setw(14) << "energy" << std::setw(8) << "%" << std::setw(12) << "toggles" << std::endl;
+	printEntry(out, root_, K, depth, 0);
+
+	out << std::endl << std::left << std::setw(40) << "class" << std::right << std::setw(8) << "count"
+	    << std::setw(14) << "energy" << std::setw(8) << "%" << std::setw(12) << "toggles" << std::endl;
+	int N = (int)classes_.size();
+	for (int k = 0; k < N && k < K; k++)
+		printEntry(out, classes_[k], K, 1, 0);
+	if (N > K)
+		out << "(" << N - K << " more)" << std::endl;
+
+	out.flags(flags);
+	out.precision(prec);
+}
@@ -0,0 +1,101 @@
+#ifndef POWERREPORT_H_
+#define POWERREPORT_H_
+
+#include <vector>
+#include <map>
+#include <string>
+#include <ostream>
+#include "Module.h"
+
+// Switching activity of leaf modules: their new output values and the
+// energy of those values. A SimContext with useActivity() counts every
+// simulation it runs here, so modules only take space while they are being
+// profiled. Modules are not owned.
+class ActivityTable
+{
+private:
+	struct Activity
+	{
+		unsigned long toggles;
+		double energy;
+		Activity() : toggles(0), energy(0) {}
+	};
+	typedef std::map<const Module*,Activity> ACTMAP_T;
+	ACTMAP_T table_;
+
+public:
+	// count a new value of an output of leaf module m
+	inline void add(const Module* m, energy_t E)
+	{
+		Activity& a = table_[m];
+		a.toggles++;
+		a.energy += E;
+	}
+
+	// activity of module m (0 if it never changed)
+	unsigned long toggles(const Module* m) const;
+	double energy(const Module* m) const;
+
+	// number of modules that changed
+	inline int size() const { return (int)table_.size(); }
+	void clear() { table_.clear(); }
+};
+
+// one line of a PowerReport: a group of modules and their activity
+struct PowerEntry
+{
+	// group (see SystemModule::submodule) or classname
+	std::string name;
+	// number of modules in the group
+	int count;
+	// output toggles and switching energy, over all leaf modules below
+	unsigned long toggles;
+	double energy;
+	// submodule groups (largest energy first)
+	std::vector<PowerEntry> children;
+
+	PowerEntry() : count(0), toggles(0), energy(0) {}
+};
+
+// Power and activity of a module hierarchy, from the activity of its leaf
+// modules in an ActivityTable. The table can be used by any number of
+// contexts and runs, so the report covers all of them (until it is cleared).
+//
+// In the hierarchy, the submodules of each system module are grouped by
+// their report group (their classname unless the system gives one), and
+// groups with the same name under instances of the same system are merged.
+// The per-class table adds up every leaf module of each class.
+class PowerReport
+{
+private:
+	PowerEntry root_;
+	std::vector<PowerEntry> classes_;
+
+	typedef std::map<std::string,PowerEntry> CLASSMAP_T;
+
+	// entry of module m, and the classes of its leaf modules
+	static void collect(Module* m, const std::string& name, const ActivityTable& activity,
+	                    PowerEntry& entry, CLASSMAP_T& classes);
+	// add entry e to the entry with the same name
+	static void merge(PowerEntry& into, const PowerEntry& e);
+	static void sort(std::vector<PowerEntry>& entries);
+	void printEntry(std::ostream& out, const PowerEntry& e, int K, int depth, int indent) const;
+
+public:
+	// collect the activity below top
+	PowerReport(Module& top, const ActivityTable& activity);
+
+	// total activity
+	inline unsigned long toggles() const { return root_.toggles; }
+	inline double energy() const { return root_.energy; }
+
+	// the hierarchy (root is top), and the leaf classes (largest energy first)
+	inline const PowerEntry& root() const { return root_; }
+	inline const std::vector<PowerEntry>& classes() const { return classes_; }
+
+	// print the hierarchy down to the given depth, with the K largest groups
+	// of each system, then the K largest leaf classes
+	void print(std::ostream& out, int K=10, int depth=3) const;
+};
+
+#endif // POWERREPORT_H_
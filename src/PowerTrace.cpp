@@ -0,0 +1,152 @@
+#include <fstream>
+#include <algorithm>
+#include <cassert>
+#include <stdint.h>
+#include "PowerTrace.h"
+
+PowerTrace::PowerTrace(delay_t width, int window) :
+	 width_(width)
+	,window_(window)
+	,offset_(0)
+	,bin_(-1)
+	,binEnergy_(0)
+	,last_(window, 0)
+	,pos_(0)
+	,sum_(0)
+	,peak_(0)
+	,peakBin_(0)
+	,energy_(0)
+	,out_(NULL)
+	,ownOut_(false)
+	,format_(POWERTRACE_CSV)
+{
+	assert(width > 0);
+	assert(window > 0);
+}
+
+PowerTrace::~PowerTrace()
+{
+	close();
+}
+
+bool PowerTrace::open(const std::string& path, powertrace_t format)
+{
+	std::ios::openmode mode = std::ios::trunc;
+	if (format == POWERTRACE_BINARY) mode |= std::ios::binary;
+	std::ofstream* out = new std::ofstream(path.c_str(), mode);
+	if (!*out)
+	{
+		delete out;
+		return false;
+	}
+	open(*out, format);
+	ownOut_ = true;
+	return true;
+}
+
+void PowerTrace::open(std::ostream& out, powertrace_t format)
+{
+	close();
+	out_ = &out;
+	ownOut_ = false;
+	format_ = format;
+
+	if (format_ == POWERTRACE_BINARY)
+	{
+		int32_t header[2] = {(int32_t)width_, (int32_t)window_};
+		out_->write("EPT1", 4);
+		out_->write((const char*)header, sizeof(header));
+	}
+	else
+		*out_ << "time,energy,power" << std::endl;
+}
+
+void PowerTrace::close()
+{
+	if (!out_) return;
+
+	// the open bin is written now, but stays open
+	writeBin();
+	out_->flush();
+	if (ownOut_) delete out_;
+	out_ = NULL;
+	ownOut_ = false;
+}
+
+void PowerTrace::writeBin()
+{
+	if (!out_ || bin_ < 0 || binEnergy_ <= 0) return;
+	if (format_ == POWERTRACE_BINARY)
+	{
+		int32_t b = bin_;
+		out_->write((const char*)&b, sizeof(b));
+		out_->write((const char*)&binEnergy_, sizeof(binEnergy_));
+	}
+	else
+		*out_ << bin_*width_ << "," << binEnergy_ << "," << binEnergy_/width_ << "\n";
+}
+
+void PowerTrace::pushBin(delay_t b, energy_t E)
+{
+	sum_ += E - last_[pos_];
+	last_[pos_] = E;
+	pos_ = (pos_ + 1) % window_;
+	if (sum_ > peak_)
+	{
+		peak_ = sum_;
+		peakBin_ = b - window_ + 1;
+	}
+}
+
+void PowerTrace::closeBin()
+{
+	writeBin();
+	pushBin(bin_, binEnergy_);
+	energy_ += binEnergy_;
+}
+
+void PowerTrace::add(delay_t T, energy_t E)
+{
+	assert(T >= 0);
+	delay_t b = (offset_ + T) / width_;
+	if (b != bin_)
+	{
+		assert(b > bin_);
+		if (bin_ >= 0) closeBin();
+
+		// empty bins in between (only a window of them matters)
+		for (delay_t k = std::max(bin_ + 1, b - window_); k < b; k++)
+			pushBin(k, 0);
+		bin_ = b;
+		binEnergy_ = 0;
+	}
+	binEnergy_ += E;
+}
+
+void PowerTrace::nextRun()
+{
+	if (bin_ >= 0)
+		offset_ = (bin_ + 1) * width_;
+}
+
+energy_t PowerTrace::energy() const
+{
+	return energy_ + ((bin_ >= 0) ? binEnergy_ : 0);
+}
+
+energy_t PowerTrace::peakPower() const
+{
+	double peak = peak_;
+	// the window that ends with the open bin
+	if (bin_ >= 0)
+		peak = std::max(peak, sum_ - last_[pos_] + binEnergy_);
+	return peak / ((double)window_ * width_);
+}
+
+delay_t PowerTrace::peakTime() const
+{
+	delay_t b = peakBin_;
+	if (bin_ >= 0 && sum_ - last_[pos_] + binEnergy_ > peak_)
+		b = bin_ - window_ + 1;
+	return std::max(b, 0) * width_;
+}
@@ -0,0 +1,91 @@
+#ifndef POWERTRACE_H_
+#define POWERTRACE_H_
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include "Module.h"
+
+// file formats of a PowerTrace
+enum powertrace_t {POWERTRACE_CSV, POWERTRACE_BINARY};
+
+// Power trace of simulations, in time bins of a fixed width.
+// Attach it to a SimContext (see SimContext::useTrace): the energy of each
+// time step is added when the step is closed, so tracing costs O(1) per step
+// and needs no wire histories. The trace keeps the peak power over a sliding
+// window of several bins (less sensitive to the delay model than the peak of
+// one time step), and can stream each bin to a file as soon as it is done.
+//
+// Every simulation started on the context is a new run, and the runs are
+// placed one after the other (each starts at a new bin).
+//
+// CSV files have a "time,energy,power" line per bin with energy.
+// Binary files start with "EPT1", the bin width and the window (int32), and
+// have an (int32 bin, float energy) record per bin with energy.
+class PowerTrace
+{
+private:
+	// bin width and bins per window
+	delay_t width_;
+	int window_;
+	// time of the current run in the trace
+	delay_t offset_;
+	// the open bin (-1 before the first) and its energy
+	delay_t bin_;
+	energy_t binEnergy_;
+	// energies of the last closed bins (ring) and their sum
+	std::vector<energy_t> last_;
+	int pos_;
+	double sum_;
+	// largest window, and its first bin
+	double peak_;
+	delay_t peakBin_;
+	// energy of the closed bins
+	double energy_;
+
+	// output (NULL if none), and whether it's ours to delete
+	std::ostream* out_;
+	bool ownOut_;
+	powertrace_t format_;
+
+	PowerTrace(const PowerTrace&);
+	PowerTrace& operator=(const PowerTrace&);
+
+	// write the open bin (if it has energy)
+	void writeBin();
+	// add bin b to the window
+	void pushBin(delay_t b, energy_t E);
+	// close the open bin
+	void closeBin();
+
+public:
+	PowerTrace(delay_t width=1, int window=1);
+	~PowerTrace();
+
+	// stream the bins to a file (or an open stream)
+	bool open(const std::string& path, powertrace_t format=POWERTRACE_CSV);
+	void open(std::ostream& out, powertrace_t format=POWERTRACE_CSV);
+	// write the open bin and stop streaming
+	void close();
+
+	// add the energy of time step T of the current run
+	// (called by the SimContext, in time order)
+	void add(delay_t T, energy_t E);
+	// start a new run after the current one
+	void nextRun();
+
+	// settings
+	inline delay_t binWidth() const { return width_; }
+	inline int window() const { return window_; }
+
+	// total energy so far
+	energy_t energy() const;
+	// peak power over a window (energy / window width), and the time the
+	// window starts at (including the open bin)
+	energy_t peakPower() const;
+	delay_t peakTime() const;
+	// number of bins so far
+	inline delay_t numBins() const { return bin_ + 1; }
+};
+
+#endif // POWERTRACE_H_
@@ -54,11 +54,13 @@ private:
 	void init()
 	{
 		int N = width();
-		submodules(3, &gap_, &sumxor_, &buf_);
+		submodule(&gap_);
+		submodule(&sumxor_, "sum XORs");
+		submodule(&buf_, "carry-in");
 
 		std::stringstream ss;
 		ss << "PrefixAdder<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		// setup initial g and p
 		for (int i = 0; i < N; i++)
@@ -96,7 +98,7 @@ std::cout << "level=" << lvl << " GP(" << h << "," << l << ") has inputs "
           << "GP(" << h << "," << l1 << ") and GP(" << h1 << "," << l << ")" << std::endl;
 #endif
 				GP* module = new GP();
-				submodule(module);
+				submodule(module, "GP tree");
 				GP& gp = *module;
 
 				G(h,l1) >> gp("g");
@@ -12,6 +12,10 @@
 
 class REG : public Module
 {
+private:
+	InPort D_, CLK_;
+	OutPort Q_;
+
 public:
 	REG(int N)
 	{
@@ -19,15 +23,35 @@ public:
 		addInput("CLK");
 		addOutput("Q", N);
 
+		D_ = inPort("D");
+		CLK_ = inPort("CLK");
+		Q_ = outPort("Q");
+
 		std::stringstream ss;
 		ss << "REG<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 	}
 
 	void propagate()
 	{
-		if (posedge("CLK"))
-			OUT("Q") <= IN("D");
+		if (posedge(CLK_))
+			OUT(Q_) <= IN(D_);
+	}
+
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+	{
+		// rising edge of CLK
+		int N = numOutputs();
+		if (!((changed[N >> 6] >> (N & 63)) & 1) || in[N] != HIGH)
+			return false;
+		for (int i = 0; i < N; i++)
+			out[i] = in[i];
+		return true;
+	}
+
+	bool hasEvaluate() const
+	{
+		return true;
 	}
 
 	delay_t delay(int inum, int onum)
@@ -65,6 +89,10 @@ public:
 
 class LATCH : public Module
 {
+private:
+	InPort D_, CLK_;
+	OutPort Q_;
+
 public:
 	LATCH(int N)
 	{
@@ -72,15 +100,34 @@ public:
 		addInput("CLK");
 		addOutput("Q", N);
 
+		D_ = inPort("D");
+		CLK_ = inPort("CLK");
+		Q_ = outPort("Q");
+
 		std::stringstream ss;
 		ss << "LATCH<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 	}
 
 	void propagate()
 	{
-		if (Bit(IN("CLK")) == HIGH)
-			OUT("Q") <= IN("D");
+		if (Bit(IN(CLK_)) == HIGH)
+			OUT(Q_) <= IN(D_);
+	}
+
+	bool evaluate(const Bit* in, const uint64_t* changed, Bit* out) const
+	{
+		int N = numOutputs();
+		if (in[N] != HIGH)
+			return false;
+		for (int i = 0; i < N; i++)
+			out[i] = in[i];
+		return true;
+	}
+
+	bool hasEvaluate() const
+	{
+		return true;
 	}
 
 	delay_t delay(int inum, int onum)
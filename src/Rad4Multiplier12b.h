@@ -161,7 +161,7 @@ public:
 
 		std::stringstream ss;
 		ss << "Rad4Multiplier12b<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 		
 		initSubmodules(N);
 		
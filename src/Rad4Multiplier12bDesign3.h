@@ -20,12 +20,12 @@ private:
 	{
 		// create submodules
 		ripple_adder_ = new RippleAdder(N*2-1);
-		submodule(ripple_adder_);
+		submodule(ripple_adder_, "final adder");
 		
 		big_save_adder_ = new SaveAdder(N-3);
-		submodule(big_save_adder_);
+		submodule(big_save_adder_, "bottom row 3:2");
 		small_save_adder_ = new SaveAdder(2);
-		submodule(small_save_adder_);
+		submodule(small_save_adder_, "bottom row 3:2");
 
 		bottom_row_4_2_adders_stage_1_.push_back(new FA());
 		bottom_row_4_2_adders_stage_1_.push_back(new FA());
@@ -43,12 +43,12 @@ private:
 
 		for(int i = 0; i < 4; i++)
 		{
-			submodule(bottom_row_4_2_adders_stage_1_[i]);
-			submodule(bottom_row_4_2_adders_stage_2_[i]);
+			submodule(bottom_row_4_2_adders_stage_1_[i], "bottom row 4:2");
+			submodule(bottom_row_4_2_adders_stage_2_[i], "bottom row 4:2");
 
 			if (i < 3)
 			{
-				submodule(bottom_row_3_2_adders_[i]);
+				submodule(bottom_row_3_2_adders_[i], "bottom row 3:2");
 			}
 		}
 
@@ -61,7 +61,7 @@ private:
 
 		for(int i = 0; i < row0_FAs_.size(); i++)
 		{
-			submodule(row0_FAs_[i]);
+			submodule(row0_FAs_[i], "row0");
 		}
 
 		row0_HAs_.push_back(new HA());
@@ -72,7 +72,7 @@ private:
 
 		for(int i = 0; i < row0_HAs_.size(); i++)
 		{
-			submodule(row0_HAs_[i]);
+			submodule(row0_HAs_[i], "row0");
 		}
 		//////////////////////////////////////////////////////////
 		row1_FAs_.push_back(new FA());
@@ -85,7 +85,7 @@ private:
 
 		for(int i = 0; i < row1_FAs_.size(); i++)
 		{
-			submodule(row1_FAs_[i]);
+			submodule(row1_FAs_[i], "row1");
 		}
 
 		row1_HAs_.push_back(new HA());
@@ -96,7 +96,7 @@ private:
 
 		for(int i = 0; i < row1_HAs_.size(); i++)
 		{
-			submodule(row1_HAs_[i]);
+			submodule(row1_HAs_[i], "row1");
 		}
 		///////////////////////////////////////////////////////////////////
 
@@ -112,14 +112,14 @@ private:
 
 		for(int i = 0; i < row2_FAs_.size(); i++)
 		{
-			submodule(row2_FAs_[i]);
+			submodule(row2_FAs_[i], "row2");
 		}
 
 		row2_HAs_.push_back(new HA());
 
 		for(int i = 0; i < row2_HAs_.size(); i++)
 		{
-			submodule(row2_HAs_[i]);
+			submodule(row2_HAs_[i], "row2");
 		}
 		///////////////////////////////////////////////////////////////////
 
@@ -133,7 +133,7 @@ private:
 
 		for(int i = 0; i < row3_FAs_.size(); i++)
 		{
-			submodule(row3_FAs_[i]);
+			submodule(row3_FAs_[i], "row3");
 		}
 
 		row3_HAs_.push_back(new HA());
@@ -143,16 +143,16 @@ private:
 
 		for(int i = 0; i < row3_HAs_.size(); i++)
 		{
-			submodule(row3_HAs_[i]);
+			submodule(row3_HAs_[i], "row3");
 		}
 		///////////////////////////////////////////////////////////////////
 
 		for (int i = 0; i <N/2; i++)
 		{
 			MultipleGenerators_.push_back(new MultipleGenerator(N,i));
-			submodule(MultipleGenerators_[i]);
+			submodule(MultipleGenerators_[i], "multiples");
 			ParallelRecoders_.push_back(new ParallelRecoder(N));
-			submodule(ParallelRecoders_[i]);
+			submodule(ParallelRecoders_[i], "recoders");
 		}
 	}
 
@@ -736,7 +736,7 @@ public:
 
 		std::stringstream ss;
 		ss << "Rad4Multiplier12b<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 		
 		initSubmodules(N);
 		
@@ -58,7 +58,7 @@ public:
 
 		std::stringstream ss;
 		ss << "RandomTree<" << levels << ",seed=" << t << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		std::vector<Module*> vecA, vecB;
 		std::vector<Module*> *tmp, *curlvl = &vecA, *prevlvl = &vecB;
@@ -11,7 +11,7 @@ class Recoder : public Module
 	public: 
 		Module()
 		{
-			classname_ = "Recoder";
+			setClassname("Recoder");
 			addInput("M0");
 			addInput("M1");
 			addInput("C");
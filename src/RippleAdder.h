@@ -53,7 +53,7 @@ public:
 		// generate classname based on group adder type
 		std::stringstream ss;
 		ss << "RippleAdder<" << N << "," << grpadder.classname() << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		// connect submodules together
 		init();
@@ -70,7 +70,7 @@ public:
 			addAdder(other.adders_[i]->clone());
 
 		// copy classname from other
-		classname_ = other.classname_;
+		setClassname(other.classname());
 
 		// connect submodules together
 		init();
@@ -24,7 +24,7 @@ public:
 
 		std::stringstream ss;
 		ss << "SaveAdder<" << N << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		// create and connect FAs
 		FAs_ = new FA[N];
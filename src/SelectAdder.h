@@ -94,7 +94,7 @@ private:
 		// generate classname based on group adder type
 		std::stringstream ss;
 		ss << "SelectAdder<" << N << "," << grpadder.classname() << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		// connect submodules together
 		init();
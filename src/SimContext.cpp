@@ -0,0 +1,206 @@
+#include <pthread.h>
+#include <algorithm>
+#include "SimContext.h"
+#include "WorkPool.h"
+#include "PowerTrace.h"
+
+// context used by this thread (set to the default context on first use)
+__thread SimContext* SimContext::current_ = NULL;
+
+// settings for new contexts
+simqueue_t   SimContext::defaultQueue   = SIMQUEUE_WHEEL;
+simhistory_t SimContext::defaultHistory = SIMHISTORY_FULL;
+simmode_t    SimContext::defaultMode    = SIMMODE_TIMED;
+int          SimContext::defaultThreads = 1;
+
+// open time steps kept in the ring (a power of 2 and a multiple of 64)
+// (gate delays are small, so almost every change lands in the ring)
+static const int STEP_RING = 1024;
+
+// each thread's default context is deleted when the thread exits
+static pthread_key_t  threadKey;
+static pthread_once_t threadKeyOnce = PTHREAD_ONCE_INIT;
+static __thread SimContext* threadDefault = NULL;
+
+static void deleteThreadContext(void* p)
+{
+	delete static_cast<SimContext*>(p);
+}
+
+static void createThreadKey()
+{
+	pthread_key_create(&threadKey, deleteThreadContext);
+}
+
+// static method
+SimContext& SimContext::threadContext()
+{
+	if (threadDefault == NULL)
+	{
+		pthread_once(&threadKeyOnce, createThreadKey);
+		threadDefault = new SimContext();
+		pthread_setspecific(threadKey, threadDefault);
+	}
+	current_ = threadDefault;
+	return *threadDefault;
+}
+
+SimContext::SimContext() :
+	 queue_(NULL)
+	,item_(NULL)
+	,time_(0)
+	,qtype_(defaultQueue)
+	,htype_(defaultHistory)
+	,mode_(defaultMode)
+	,threads_(defaultThreads)
+	,pool_(NULL)
+	,writes_(NULL)
+	,stepEnergy_(STEP_RING, 0)
+	,stepUsed_(STEP_RING/64, 0)
+	,trace_(NULL)
+	,activity_(NULL)
+{
+	resetPower();
+}
+
+SimContext::~SimContext()
+{
+	reset();
+	delete pool_;
+	for (size_t w = 0; w < lanes_.size(); w++)
+		delete lanes_[w];
+}
+
+void SimContext::useThreads(int N)
+{
+	assert(N > 0);
+	threads_ = N;
+}
+
+void SimContext::startPool()
+{
+	if (pool_ != NULL && pool_->size() == threads_)
+		return;
+	delete pool_;
+	pool_ = new WorkPool(threads_);
+	while ((int)lanes_.size() < threads_)
+		lanes_.push_back(new SimContext());
+}
+
+void SimContext::reset()
+{
+	if (queue_ != NULL)
+	{
+		delete queue_;
+		queue_ = NULL;
+	}
+	time_ = 0;
+	item_ = NULL;
+}
+
+void SimContext::resetPower()
+{
+	energy_ = 0;
+	peak_ = 0;
+	energyTime_ = DELAY_T_MIN;
+	std::fill(stepEnergy_.begin(), stepEnergy_.end(), 0);
+	std::fill(stepUsed_.begin(), stepUsed_.end(), 0);
+	farEnergy_.clear();
+	stepBase_ = 0;
+	if (trace_) trace_->nextRun();
+}
+
+void SimContext::addEnergy(energy_t E, delay_t T)
+{
+	energy_ += E;
+	if (T > energyTime_) energyTime_ = T;
+	if (E == 0) return;
+
+	// a step that was closed already (only outside of a simulation)
+	if (T < stepBase_)
+	{
+		if (E > peak_) peak_ = E;
+		return;
+	}
+
+	// close the past steps to make room, or keep it for later
+	if (T - stepBase_ >= STEP_RING)
+	{
+		closeSteps(time_);
+		if (T - stepBase_ >= STEP_RING)
+		{
+			farEnergy_[T] += E;
+			return;
+		}
+	}
+	int pos = T & (STEP_RING-1);
+	stepEnergy_[pos] += E;
+	stepUsed_[pos >> 6] |= (uint64_t)1 << (pos & 63);
+}
+
+delay_t SimContext::nextStep() const
+{
+	// search the ring from stepBase_, then wrap around
+	int base = stepBase_ & (STEP_RING-1);
+	int W = STEP_RING/64;
+	for (int k = 0; k <= W; k++)
+	{
+		int w = ((base >> 6) + k) % W;
+		uint64_t bits = stepUsed_[w];
+		// the first word is split by stepBase_
+		if (k == 0) bits &= ~(uint64_t)0 << (base & 63);
+		else if (k == W) bits &= ~(~(uint64_t)0 << (base & 63));
+		if (bits)
+		{
+			int pos = w*64 + __builtin_ctzll(bits);
+			return stepBase_ + ((pos - base) & (STEP_RING-1));
+		}
+	}
+	return farEnergy_.empty() ? DELAY_T_MAX : (*farEnergy_.begin()).first;
+}
+
+void SimContext::closeSteps(delay_t T)
+{
+	// visit the steps with energy only
+	for (delay_t t = nextStep(); t <= T && t != DELAY_T_MAX; t = nextStep())
+	{
+		// the ring is empty: jump to the next step
+		if (t - stepBase_ >= STEP_RING)
+		{
+			stepBase_ = t;
+			moveSteps();
+		}
+		int pos = t & (STEP_RING-1);
+		energy_t E = stepEnergy_[pos];
+		stepEnergy_[pos] = 0;
+		stepUsed_[pos >> 6] &= ~((uint64_t)1 << (pos & 63));
+		if (E > peak_) peak_ = E;
+		if (trace_) trace_->add(t, E);
+		stepBase_ = t + 1;
+		moveSteps();
+	}
+	// the steps up to T are empty
+	if (T != DELAY_T_MAX && T >= stepBase_)
+	{
+		stepBase_ = T + 1;
+		moveSteps();
+	}
+}
+
+void SimContext::moveSteps()
+{
+	while (!farEnergy_.empty() && (*farEnergy_.begin()).first - stepBase_ < STEP_RING)
+	{
+		std::map<delay_t,energy_t>::iterator iter = farEnergy_.begin();
+		int pos = (*iter).first & (STEP_RING-1);
+		stepEnergy_[pos] += (*iter).second;
+		stepUsed_[pos >> 6] |= (uint64_t)1 << (pos & 63);
+		farEnergy_.erase(iter);
+	}
+}
+
+void SimContext::powerStats(energy_t* avgpow, energy_t* peakpow) const
+{
+	if (avgpow) *avgpow = averagePower();
+	if (peakpow) *peakpow = peakPower();
+}
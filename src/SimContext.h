@@ -0,0 +1,171 @@
+#ifndef SIMCONTEXT_H_
+#define SIMCONTEXT_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Module.h"
+#include "SimQueue.h"
+
+class WorkPool;	// WorkPool.h
+class PowerTrace;	// PowerTrace.h
+class ActivityTable;	// PowerReport.h
+
+// An output value set during a parallel step (applied after the step).
+struct SimWrite
+{
+	Module* module;
+	int onum;
+	Bit b;
+	delay_t T;
+	SimWrite(Module* m, int o, Bit bit, delay_t t) : module(m), onum(o), b(bit), T(t) {}
+};
+
+// The state of one simulation: the queue and the current time.
+// Contexts can be passed to Module::simStart() and Module::simStep(), so independent
+// simulations can run on different threads or be interleaved on one thread.
+// Each thread also has a default context, which is used by Module::simulate()
+// and the other static simulation methods.
+// A module can only be simulated by one context at a time.
+//
+// With useThreads(N), all the modules that are propagated at the same time are
+// propagated in parallel by N threads. This is possible because outputs are
+// always set after the current time, so these modules only read settled
+// values. The outputs they set are buffered, and applied afterwards in queue
+// order, so the results are exactly the same as with one thread.
+class SimContext
+{
+private:
+	// simulation queue (NULL if not simulating)
+	SimQueue* queue_;
+	// the item being propagated (NULL while propagating root modules)
+	const SimQueue::QItem* item_;
+	// current simulation time
+	delay_t time_;
+	// settings
+	simqueue_t qtype_;
+	simhistory_t htype_;
+	simmode_t mode_;
+	int threads_;
+
+	// parallel steps
+	// (each worker propagates in its own lane, which buffers the outputs)
+	WorkPool* pool_;
+	std::vector<SimContext*> lanes_;
+	std::vector<const SimQueue::QItem*> bucket_;
+	std::vector< std::vector<SimWrite> > pending_;
+	// outputs set by the module being propagated (only used by lanes)
+	std::vector<SimWrite>* writes_;
+
+	// power accounting (see addEnergy)
+	// total energy, energy of the busiest closed time step, and last time
+	// with energy (DELAY_T_MIN if none)
+	energy_t energy_;
+	energy_t peak_;
+	delay_t energyTime_;
+	// energy of the open time steps in [stepBase_,stepBase_+STEP_RING)
+	// (time T is at stepEnergy_[T & (STEP_RING-1)], with its bit set in
+	// stepUsed_ if it has energy), and of the later steps
+	std::vector<energy_t> stepEnergy_;
+	std::vector<uint64_t> stepUsed_;
+	std::map<delay_t,energy_t> farEnergy_;
+	delay_t stepBase_;
+	// trace of the closed time steps (NULL if none)
+	PowerTrace* trace_;
+	// activity of each leaf module (NULL if none)
+	ActivityTable* activity_;
+
+	// close the time steps up to T (their energy can't change anymore)
+	void closeSteps(delay_t T);
+	// first open time step with energy (DELAY_T_MAX if none)
+	delay_t nextStep() const;
+	// move the later steps that are now inside the ring into it
+	void moveSteps();
+
+	// context used by this thread
+	static __thread SimContext* current_;
+	// default context of this thread
+	static SimContext& threadContext();
+
+	// settings for new contexts
+	static simqueue_t defaultQueue;
+	static simhistory_t defaultHistory;
+	static simmode_t defaultMode;
+	static int defaultThreads;
+
+	// create (or resize) the thread pool
+	void startPool();
+
+	SimContext(const SimContext&);
+	SimContext& operator=(const SimContext&);
+
+	// the simulation methods work on the current context
+	friend class Module;
+
+public:
+	SimContext();
+	~SimContext();
+
+	// get the context used by this thread
+	// (the one being simulated, otherwise the thread's default context)
+	static inline SimContext& current()
+	{
+		return current_ ? *current_ : threadContext();
+	}
+
+	// get current simulation time
+	inline delay_t time() const { return time_; }
+
+	// are there events left to simulate?
+	inline bool pending() const { return queue_ && !queue_->empty(); }
+
+	// choose the queue implementation for the next simulation
+	void useQueue(simqueue_t type) { qtype_ = type; }
+
+	// choose how much wire history to keep
+	void useHistory(simhistory_t type) { htype_ = type; }
+	simhistory_t history() const { return htype_; }
+
+	// choose timed or levelized simulation for Module::simulate()
+	void useMode(simmode_t type) { mode_ = type; }
+	simmode_t mode() const { return mode_; }
+
+	// number of threads that propagate modules (1 = no parallel steps)
+	void useThreads(int N);
+	int threads() const { return threads_; }
+
+	// reset simulation state (queue and time)
+	// (delay tables are kept in the DelayCache, and power stats are kept
+	// until the next simulation starts)
+	void reset();
+
+	// Power of the simulation, accumulated while it runs.
+	// Each new value of a leaf module output adds the module's energy() to
+	// the time it is set at. Outputs are always set after the current time,
+	// so time steps up to the current time are closed, and only the steps
+	// that can still change are kept. Available at any time in O(1):
+	// total energy, average power (energy / last time with energy), and
+	// peak power (max energy of one closed time step, so all steps once
+	// the simulation is done).
+	inline energy_t energy() const { return energy_; }
+	inline delay_t energyTime() const { return energyTime_; }
+	inline energy_t averagePower() const { return (energyTime_ > 0) ? energy_ / energyTime_ : 0; }
+	inline energy_t peakPower() const { return peak_; }
+	void powerStats(energy_t* avgpow, energy_t* peakpow) const;
+	// clear the power stats (done when a simulation starts)
+	void resetPower();
+	// add the energy of every closed time step to a trace (NULL stops)
+	// each simulation is a new run of the trace
+	void useTrace(PowerTrace* trace) { trace_ = trace; }
+	PowerTrace* trace() const { return trace_; }
+	// count the new output values of every leaf module, and their energy, in
+	// a table (NULL stops), which adds up all simulations that use it
+	// (see PowerReport)
+	void useActivity(ActivityTable* activity) { activity_ = activity; }
+	ActivityTable* activity() const { return activity_; }
+	// add the energy of an output change at time T
+	void addEnergy(energy_t E, delay_t T);
+};
+
+#endif // SIMCONTEXT_H_
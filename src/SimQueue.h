@@ -2,49 +2,224 @@
 #define SIMQUEUE_H_
 
 #include <set>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <stdint.h>
+#include "BitHistory.h"
 
 class Module;
 
-// Simulation queue used by Module methods.
-// Essentially a priority queue of (Module,time) pairs ordered by time.
-class SimQueue
+// Pool of zeroed bitmaps for InputSets of wide modules.
+// Bitmaps are recycled by size, so a running simulation doesn't allocate.
+class InputPool
 {
+private:
+	// free bitmaps, indexed by number of words
+	std::vector< std::vector<uint64_t*> > free_;
+	// storage chunks (bitmaps are carved from these)
+	std::vector<uint64_t*> chunks_;
+	int chunkUsed_;
+
+	static const int CHUNK_WORDS = 4096;
+
+	InputPool(const InputPool&);
+	InputPool& operator=(const InputPool&);
+
 public:
-	// The objects stored in the queue
-	struct QItem
+	InputPool() : chunkUsed_(CHUNK_WORDS) {}
+
+	~InputPool()
+	{
+		for (size_t i = 0; i < chunks_.size(); i++)
+			delete [] chunks_[i];
+	}
+
+	// get a zeroed bitmap
+	uint64_t* alloc(int nwords)
 	{
-		Module* module;        // the module whose inputs were changed
-		delay_t T;             // the time at which the inputs changed
-		std::set<int> inputs;  // the input numbers that changed
-		QItem(Module* m, delay_t t) : module(m), T(t) {}
-		bool operator<(const QItem& other) const
+		if (nwords < (int)free_.size() && !free_[nwords].empty())
 		{
-			if (T == other.T)
-				return module < other.module;
-			return T < other.T;
+			uint64_t* p = free_[nwords].back();
+			free_[nwords].pop_back();
+			return p;
 		}
+		// carve from a chunk (very wide bitmaps get their own chunk)
+		if (nwords > CHUNK_WORDS)
+		{
+			uint64_t* p = new uint64_t[nwords]();
+			chunks_.push_back(p);
+			return p;
+		}
+		if (chunkUsed_ + nwords > CHUNK_WORDS)
+		{
+			chunks_.push_back(new uint64_t[CHUNK_WORDS]());
+			chunkUsed_ = 0;
+		}
+		uint64_t* p = chunks_.back() + chunkUsed_;
+		chunkUsed_ += nwords;
+		return p;
+	}
+
+	// return a bitmap (must be all zeroes)
+	void release(uint64_t* p, int nwords)
+	{
+		if (nwords >= (int)free_.size())
+			free_.resize(nwords+1);
+		free_[nwords].push_back(p);
+	}
+};
+
+// Set of input numbers that changed.
+// Up to 64 inputs are kept in an inline bit mask.
+// Wider modules use a bitmap from an InputPool.
+struct InputSet
+{
+	int nwords; // 0 for the inline mask
+	union
+	{
+		uint64_t mask;
+		uint64_t* words;
 	};
+
+	InputSet() : nwords(0), mask(0) {}
+
+	// prepare for a module with Nin inputs
+	void init(int Nin, InputPool& pool)
+	{
+		if (Nin > 64)
+		{
+			nwords = (Nin + 63) / 64;
+			words = pool.alloc(nwords);
+		}
+	}
+
+	// give the bitmap back to the pool
+	void release(InputPool& pool)
+	{
+		if (!nwords) return;
+		for (int i = 0; i < nwords; i++)
+			words[i] = 0;
+		pool.release(words, nwords);
+		nwords = 0;
+		mask = 0;
+	}
+
+	// add an input number
+	inline void insert(int i)
+	{
+		assert(i >= 0 && (nwords ? i < 64*nwords : i < 64));
+		if (nwords) words[i >> 6] |= (uint64_t)1 << (i & 63);
+		else mask |= (uint64_t)1 << i;
+	}
+
+	// check for an input number
+	inline bool count(int i) const
+	{
+		if (nwords) return (words[i >> 6] >> (i & 63)) & 1;
+		return i < 64 && ((mask >> i) & 1);
+	}
+
+	// access the bits as an array of words
+	// (input i is bit i%64 of word i/64)
+	inline const uint64_t* data() const { return nwords ? words : &mask; }
+	inline int numWords() const { return nwords ? nwords : 1; }
+
+	// number of inputs in the set
+	int size() const
+	{
+		const uint64_t* w = data();
+		int N = numWords(), n = 0;
+		for (int i = 0; i < N; i++)
+			n += __builtin_popcountll(w[i]);
+		return n;
+	}
+};
+
+// The objects stored in a simulation queue
+// KEY is the thing to be simulated (usually a Module*)
+template<class KEY>
+struct QItemT
+{
+	KEY key;               // the module whose inputs were changed
+	delay_t T;             // the time at which the inputs changed
+	InputSet inputs;       // the input numbers that changed
+	QItemT(KEY k, delay_t t) : key(k), T(t) {}
+	bool operator<(const QItemT& other) const
+	{
+		if (T == other.T)
+			return key < other.key;
+		return T < other.T;
+	}
+};
+
+// Simulation queue used by Module methods.
+// Essentially a priority queue of (Module,time) pairs ordered by time.
+// There are several implementations (see simqueue_t in Module.h).
+class SimQueue
+{
+public:
+	typedef QItemT<Module*> QItem;
+
+	virtual ~SimQueue() {}
+
+	// is the queue empty?
+	virtual bool empty() const = 0;
+
+	// get the next item
+	virtual const QItem* top() = 0;
+
+	// get all items at the time of the next item, in the order they will be popped
+	// (they stay in the queue until they are popped, and pushing items
+	// at later times doesn't move them)
+	virtual void topAll(std::vector<const QItem*>& items) = 0;
+
+	// push an item (Nin is the number of inputs of the module)
+	virtual void push(Module* m, delay_t T, int inum, int Nin) = 0;
+
+	// remove the next item
+	virtual void pop() = 0;
+};
+
+// Queue implemented as a balanced tree of items.
+// Every push is O(log n).
+class SetQueue : public SimQueue
+{
+public:
 	typedef std::set<QItem> QUEUE_T;
 	typedef QUEUE_T::iterator QITER_T;
 
 private:
 	// the actual queue
 	QUEUE_T items_;
+	// bitmaps for wide modules
+	InputPool pool_;
 
 public:
 	// is the queue empty?
 	bool empty() const { return items_.empty(); }
 
 	// get the next item
-	const QItem* top() const { return &(*(items_.begin())); }
+	const QItem* top() { return &(*(items_.begin())); }
+
+	// get all items at the time of the next item
+	void topAll(std::vector<const QItem*>& items)
+	{
+		items.clear();
+		delay_t T = (*items_.begin()).T;
+		for (QITER_T iter = items_.begin(); iter != items_.end() && (*iter).T == T; iter++)
+			items.push_back(&(*iter));
+	}
 
 	// push an item
-	void push(Module* m, delay_t T, int inum)
+	void push(Module* m, delay_t T, int inum, int Nin)
 	{
 		QItem item(m,T);
 		QITER_T iter = items_.find(item);
 		if (iter == items_.end())
 		{
+			item.inputs.init(Nin, pool_);
 			item.inputs.insert(inum);
 			items_.insert(item);
 		}
@@ -56,7 +231,301 @@ public:
 	}
 
 	// remove the next item
-	void pop() { items_.erase(items_.begin()); }
+	void pop()
+	{
+		QItem& item = const_cast<QItem&>(*items_.begin());
+		item.inputs.release(pool_);
+		items_.erase(items_.begin());
+	}
+};
+
+// hash functions for queue keys
+inline uint32_t qhash(const void* p)
+{
+	uintptr_t x = reinterpret_cast<uintptr_t>(p) >> 3;
+	return (uint32_t)(x ^ (x >> 29)) * 2654435761u;
+}
+
+inline uint32_t qhash(int i)
+{
+	return (uint32_t)i * 2654435761u;
+}
+
+// Timing wheel (calendar queue).
+// There is one bucket for every time in the window [now, now+size).
+// Items further in the future wait in an ordered overflow map until
+// the window reaches them. Since gate delays are small, almost every
+// push lands in the wheel, so push/pop are O(1).
+// Items within a bucket are popped in the order they were first pushed.
+template<class KEY>
+class TimingWheel
+{
+public:
+	typedef QItemT<KEY> ITEM_T;
+
+private:
+	// items within a bucket are merged by key
+	// small buckets are searched linearly, big buckets use a hash index
+	struct Bucket
+	{
+		struct Slot { uint32_t stamp; int pos; };
+		std::vector<ITEM_T> items;
+		std::vector<Slot> index;	// open addressing (lazily created)
+		uint32_t stamp;				// slots with other stamps are empty
+
+		Bucket() : stamp(1) {}
+
+		// find the item for a key (or create it)
+		ITEM_T& get(KEY k, delay_t T, bool& created)
+		{
+			created = false;
+			int N = items.size();
+			if (N > LINEAR_MAX)
+			{
+				uint32_t mask = index.size() - 1;
+				for (uint32_t h = qhash(k) & mask; index[h].stamp == stamp; h = (h+1) & mask)
+					if (items[index[h].pos].key == k)
+						return items[index[h].pos];
+			}
+			else
+			{
+				for (int i = 0; i < N; i++)
+					if (items[i].key == k)
+						return items[i];
+			}
+
+			// new item
+			created = true;
+			items.push_back(ITEM_T(k,T));
+			if (N >= LINEAR_MAX)
+			{
+				if (N == LINEAR_MAX || 2*(N+1) > (int)index.size())
+					reindex();
+				else
+					insert(N);
+			}
+			return items.back();
+		}
+
+		// add item position to the hash index
+		void insert(int pos)
+		{
+			uint32_t mask = index.size() - 1;
+			uint32_t h = qhash(items[pos].key) & mask;
+			while (index[h].stamp == stamp) h = (h+1) & mask;
+			index[h].stamp = stamp;
+			index[h].pos = pos;
+		}
+
+		// rebuild the hash index for all items
+		void reindex()
+		{
+			int N = items.size();
+			int size = index.size() < 16 ? 16 : index.size();
+			while (size < 4*N) size *= 2;
+			if (size != (int)index.size())
+				index.assign(size, Slot());
+			newStamp();
+			for (int i = 0; i < N; i++)
+				insert(i);
+		}
+
+		// invalidate all slots
+		void newStamp()
+		{
+			if (++stamp) return;
+			index.assign(index.size(), Slot());
+			stamp = 1;
+		}
+
+		// remove all items
+		void clear(InputPool& pool)
+		{
+			int N = items.size();
+			for (int i = 0; i < N; i++)
+				items[i].inputs.release(pool);
+			items.clear();
+			newStamp();
+		}
+
+		void swap(Bucket& other)
+		{
+			items.swap(other.items);
+			index.swap(other.index);
+			std::swap(stamp, other.stamp);
+		}
+	};
+
+	static const int LINEAR_MAX = 8;
+
+	std::vector<Bucket> wheel_;
+	int mask_;
+	delay_t now_;	// time of the current bucket
+	int pos_;		// next item to pop from the current bucket
+	int count_;		// items in the wheel that weren't popped yet
+
+	// items beyond the window
+	typedef std::map<delay_t,Bucket> FARMAP_T;
+	FARMAP_T far_;
+
+	// bitmaps for wide keys
+	InputPool pool_;
+
+	inline Bucket& bucket(delay_t T) { return wheel_[T & mask_]; }
+
+	// move overflow items that are now inside the window into the wheel
+	void migrate()
+	{
+		while (!far_.empty() && (*far_.begin()).first - now_ <= mask_)
+		{
+			typename FARMAP_T::iterator iter = far_.begin();
+			Bucket& b = bucket((*iter).first);
+			assert(b.items.empty());
+			b.swap((*iter).second);
+			count_ += b.items.size();
+			far_.erase(iter);
+		}
+	}
+
+public:
+	// window size must be a power of 2
+	TimingWheel(int size=1024) : wheel_(size), mask_(size-1), now_(0), pos_(0), count_(0)
+	{
+		assert(size > 0 && (size & mask_) == 0);
+	}
+
+	// is the queue empty?
+	bool empty() const { return count_ == 0 && far_.empty(); }
+
+	// get the next item
+	ITEM_T* top()
+	{
+		assert(!empty());
+		Bucket* b = &bucket(now_);
+		while (pos_ == (int)b->items.size())
+		{
+			// current time is done
+			b->clear(pool_);
+			pos_ = 0;
+			// jump ahead if the wheel is empty
+			if (count_ == 0)
+				now_ = (*far_.begin()).first;
+			else
+				now_++;
+			migrate();
+			b = &bucket(now_);
+		}
+		return &b->items[pos_];
+	}
+
+	// get the next item if it is before time Tend (otherwise NULL)
+	// (unlike top(), this doesn't move to Tend or later,
+	// so items can still be pushed at any time >= Tend)
+	ITEM_T* topBefore(delay_t Tend)
+	{
+		Bucket* b = &bucket(now_);
+		while (pos_ == (int)b->items.size())
+		{
+			if (empty()) return NULL;
+			delay_t next = (count_ == 0) ? (*far_.begin()).first : now_+1;
+			if (next >= Tend) return NULL;
+			// current time is done
+			b->clear(pool_);
+			pos_ = 0;
+			now_ = next;
+			migrate();
+			b = &bucket(now_);
+		}
+		return (now_ < Tend) ? &b->items[pos_] : NULL;
+	}
+
+	// time of the next item (DELAY_T_MAX if empty), without moving to it
+	delay_t nextTime() const
+	{
+		if (count_ > 0)
+		{
+			for (delay_t T = now_; T <= now_ + mask_; T++)
+			{
+				const Bucket& b = wheel_[T & mask_];
+				if ((int)b.items.size() > (T == now_ ? pos_ : 0))
+					return T;
+			}
+		}
+		return far_.empty() ? DELAY_T_MAX : (*far_.begin()).first;
+	}
+
+	// get all items at the time of the next item
+	// (the current bucket only changes when it is done)
+	void topAll(std::vector<const ITEM_T*>& items)
+	{
+		items.clear();
+		top();
+		Bucket& b = bucket(now_);
+		int N = b.items.size();
+		for (int i = pos_; i < N; i++)
+			items.push_back(&b.items[i]);
+	}
+
+	// push an item, merging with an existing item for the same key and time
+	// (Nin is the number of inputs of the key)
+	void push(KEY k, delay_t T, int inum, int Nin)
+	{
+		assert(T >= now_);
+		bool far = T - now_ > mask_;
+		bool created;
+		ITEM_T& item = (far ? far_[T] : bucket(T)).get(k,T,created);
+		if (created)
+		{
+			item.inputs.init(Nin, pool_);
+			if (!far) count_++;
+		}
+		item.inputs.insert(inum);
+	}
+
+	// remove all items and restart at time 0
+	void clear()
+	{
+		for (size_t i = 0; i < wheel_.size(); i++)
+			wheel_[i].clear(pool_);
+		for (typename FARMAP_T::iterator iter = far_.begin(); iter != far_.end(); iter++)
+			(*iter).second.clear(pool_);
+		far_.clear();
+		now_ = 0;
+		pos_ = 0;
+		count_ = 0;
+	}
+
+	// remove the next item
+	void pop()
+	{
+		assert(count_ > 0);
+		assert(pos_ < (int)bucket(now_).items.size());
+		pos_++;
+		count_--;
+	}
+};
+
+// Queue implemented as a timing wheel of Module items.
+class WheelQueue : public SimQueue
+{
+private:
+	TimingWheel<Module*> wheel_;
+
+public:
+	// is the queue empty?
+	bool empty() const { return wheel_.empty(); }
+
+	// get the next item
+	const QItem* top() { return wheel_.top(); }
+
+	// get all items at the time of the next item
+	void topAll(std::vector<const QItem*>& items) { wheel_.topAll(items); }
+
+	// push an item
+	void push(Module* m, delay_t T, int inum, int Nin) { wheel_.push(m,T,inum,Nin); }
+
+	// remove the next item
+	void pop() { wheel_.pop(); }
 };
 
 #endif // SIMQUEUE_H_
@@ -82,7 +82,7 @@ std::cout << "SKIP INIT DONE " << i << std::endl;
 		// generate classname based on group adder type
 		std::stringstream ss;
 		ss << "SkipAdder<" << N << "," << grpadder.classname() << ">";
-		classname_ = ss.str();
+		setClassname(ss.str());
 
 		// connect submodules together
 		init();
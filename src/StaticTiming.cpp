@@ -0,0 +1,720 @@
+#include <map>
+#include <set>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include "StaticTiming.h"
+#include "WorkPool.h"
+#include "Wire.h"
+
+StaticTiming::StaticTiming(const Netlist& net, int threads) :
+	 net_(net)
+	,loops_(false)
+	,netIn_(net.numNets(), -1)
+	,netOut_(net.numNets(), 0)
+	,writer_(net.numNets(), -1)
+	,readers_(net.numNets())
+	,Tcrit_(DELAY_T_MIN)
+	,Treq_(DELAY_T_MIN)
+	,Tset_(DELAY_T_MIN)
+	,relevel_(false)
+	,cellQueued_(net.numCells(), 0)
+	,netQueued_(net.numNets(), 0)
+	,threads_(threads)
+{
+	assert(threads > 0);
+
+	int C = net_.numCells();
+	for (int c = 0; c < C; c++)
+	{
+		Module* m = net_.cell(c);
+		int Nin = net_.numInputs(c);
+		int Nout = net_.numOutputs(c);
+		int p0 = net_.firstInput(c);
+		int q0 = net_.firstOutput(c);
+
+		// copy the pins and arcs, so they can be edited
+		bool dense = (Nin*Nout <= MAX_DENSE_ARCS);
+		for (int p = p0; p < p0 + Nin; p++)
+		{
+			int n = net_.inputNet(p);
+			inNet_.push_back(n);
+			load_.push_back(m->load(p - p0));
+			inCell_.push_back(c);
+			if (n >= 0) readers_[n].push_back(p);
+
+			arcStart_.push_back(arcIn_.size());
+			int a0 = arcIn_.size();
+			if (dense)
+			{
+				for (int o = 0; o < Nout; o++)
+				{
+					arcIn_.push_back(p);
+					arcOut_.push_back(q0 + o);
+					arcDelay_.push_back(DELAY_T_MIN);
+				}
+			}
+			for (int a = net_.firstArc(p); a < net_.endArc(p); a++)
+			{
+				if (dense)
+				{
+					arcDelay_[a0 + net_.arcOutput(a)] = net_.arcDelay(a);
+					continue;
+				}
+				arcIn_.push_back(p);
+				arcOut_.push_back(q0 + net_.arcOutput(a));
+				arcDelay_.push_back(net_.arcDelay(a));
+			}
+		}
+		for (int q = q0; q < q0 + Nout; q++)
+		{
+			writer_[net_.outputNet(q)] = q;
+			fanout_.push_back(net_.outputFanout(q));
+			pinCell_.push_back(c);
+		}
+	}
+
+	arcStart_.push_back(arcIn_.size());
+
+	// arcs by output pin
+	int Q = pinCell_.size();
+	revStart_.assign(Q+1, 0);
+	for (size_t a = 0; a < arcOut_.size(); a++)
+		revStart_[arcOut_[a]+1]++;
+	for (int q = 0; q < Q; q++)
+		revStart_[q+1] += revStart_[q];
+	revArc_.resize(arcOut_.size());
+	std::vector<int> fill(revStart_.begin(), revStart_.end()-1);
+	for (size_t a = 0; a < arcOut_.size(); a++)
+		revArc_[fill[arcOut_[a]]++] = a;
+
+	// find the nets of the top-level ports
+	std::map<const Wire*,int> netmap;
+	for (int n = 0; n < net_.numNets(); n++)
+		netmap[net_.net(n)] = n;
+
+	Module* top = net_.top();
+	topIn_.assign(top->numInputs(), -1);
+	for (int i = top->numInputs()-1; i >= 0; i--)
+	{
+		std::map<const Wire*,int>::iterator iter = netmap.find(top->inputWire(i));
+		if (iter == netmap.end()) continue;
+		topIn_[i] = (*iter).second;
+		// paths start at the first input of a net
+		netIn_[topIn_[i]] = i;
+	}
+	topOut_.assign(top->numOutputs(), -1);
+	for (int o = 0; o < top->numOutputs(); o++)
+	{
+		std::map<const Wire*,int>::iterator iter = netmap.find(top->outputWire(o));
+		if (iter == netmap.end()) continue;
+		topOut_[o] = (*iter).second;
+		netOut_[topOut_[o]] = 1;
+	}
+
+	analyze();
+}
+
+void StaticTiming::levelize()
+{
+	int C = net_.numCells();
+	level_.assign(C, 0);
+	order_.clear();
+	loops_ = false;
+
+	// a cell is placed after all the cells that drive its timed inputs
+	// (so e.g. the D input of a register doesn't close a loop)
+	std::vector<int> pending(C, 0);
+	for (int p = 0; p < (int)inNet_.size(); p++)
+		if (inNet_[p] >= 0 && writer_[inNet_[p]] >= 0 && isTimed(p))
+			pending[inCell_[p]]++;
+	for (int c = 0; c < C; c++)
+		if (pending[c] == 0)
+			order_.push_back(c);
+
+	int Lmax = 0;
+	for (size_t k = 0; k < order_.size(); k++)
+	{
+		int c = order_[k];
+		if (level_[c] > Lmax) Lmax = level_[c];
+		int q0 = net_.firstOutput(c);
+		for (int q = q0; q < q0 + net_.numOutputs(c); q++)
+		{
+			const std::vector<int>& readers = readers_[net_.outputNet(q)];
+			for (size_t r = 0; r < readers.size(); r++)
+			{
+				if (!isTimed(readers[r])) continue;
+				int c2 = inCell_[readers[r]];
+				if (level_[c2] <= level_[c]) level_[c2] = level_[c] + 1;
+				if (--pending[c2] == 0) order_.push_back(c2);
+			}
+		}
+	}
+
+	// cells in loops go last, on their own level
+	if ((int)order_.size() < C)
+	{
+		loops_ = true;
+		for (int c = 0; c < C; c++)
+		{
+			if (pending[c] <= 0) continue;
+			level_[c] = Lmax + 1;
+			order_.push_back(c);
+		}
+	}
+}
+
+bool StaticTiming::raiseLevel(int c, int L)
+{
+	int C = net_.numCells();
+	std::vector< std::pair<int,int> > stack(1, std::make_pair(c, L));
+	while (!stack.empty())
+	{
+		c = stack.back().first;
+		L = stack.back().second;
+		stack.pop_back();
+		if (level_[c] >= L) continue;
+		// more levels than cells: there's a loop
+		if (L >= C) return false;
+		level_[c] = L;
+
+		int q0 = net_.firstOutput(c);
+		for (int q = q0; q < q0 + net_.numOutputs(c); q++)
+		{
+			const std::vector<int>& readers = readers_[net_.outputNet(q)];
+			for (size_t r = 0; r < readers.size(); r++)
+				if (level_[inCell_[readers[r]]] <= L && isTimed(readers[r]))
+					stack.push_back(std::make_pair(inCell_[readers[r]], L+1));
+		}
+	}
+	return true;
+}
+
+bool StaticTiming::isTimed(int p) const
+{
+	for (int a = arcStart_[p]; a < arcStart_[p+1]; a++)
+		if (arcDelay_[a] > 0)
+			return true;
+	return false;
+}
+
+int StaticTiming::findArc(int c, int inum, int onum) const
+{
+	int p = net_.firstInput(c) + inum;
+	int q = net_.firstOutput(c) + onum;
+	for (int a = arcStart_[p]; a < arcStart_[p+1]; a++)
+		if (arcOut_[a] == q)
+			return a;
+	return -1;
+}
+
+delay_t StaticTiming::pinArrival(int q) const
+{
+	delay_t T = DELAY_T_MIN;
+	for (int k = revStart_[q]; k < revStart_[q+1]; k++)
+	{
+		int a = revArc_[k];
+		int n = inNet_[arcIn_[a]];
+		if (n < 0 || arrival_[n] == DELAY_T_MIN || arcDelay_[a] <= 0) continue;
+		delay_t t = arrival_[n] + arcTotal(arcDelay_[a], q);
+		if (t > T) T = t;
+	}
+	return T;
+}
+
+delay_t StaticTiming::netDown(int n) const
+{
+	delay_t D = netOut_[n] ? 0 : DELAY_T_MIN;
+	const std::vector<int>& readers = readers_[n];
+	for (size_t r = 0; r < readers.size(); r++)
+	{
+		int p = readers[r];
+		for (int a = arcStart_[p]; a < arcStart_[p+1]; a++)
+		{
+			if (arcDelay_[a] <= 0) continue;
+			int q = arcOut_[a];
+			delay_t t = down_[net_.outputNet(q)];
+			if (t == DELAY_T_MIN) continue;
+			t += arcTotal(arcDelay_[a], q);
+			if (t > D) D = t;
+		}
+	}
+	return D;
+}
+
+void StaticTiming::findCritical()
+{
+	Tcrit_ = DELAY_T_MIN;
+	for (size_t o = 0; o < topOut_.size(); o++)
+		if (topOut_[o] >= 0 && arrival_[topOut_[o]] > Tcrit_)
+			Tcrit_ = arrival_[topOut_[o]];
+	Treq_ = (Tset_ == DELAY_T_MIN) ? Tcrit_ : Tset_;
+}
+
+void StaticTiming::analyze(delay_t Treq)
+{
+	Tset_ = Treq;
+	dirtyCells_.clear();
+	dirtyNets_.clear();
+	relevel_ = false;
+	levelize();
+
+	// arrival times: every cell after all the cells that drive it
+	int N = net_.numNets();
+	arrival_.assign(N, DELAY_T_MIN);
+	for (size_t i = 0; i < topIn_.size(); i++)
+		if (topIn_[i] >= 0 && writer_[topIn_[i]] < 0)
+			arrival_[topIn_[i]] = 0;
+	int C = order_.size();
+	for (int k = 0; k < C; k++)
+	{
+		int c = order_[k];
+		int q0 = net_.firstOutput(c);
+		for (int q = q0; q < q0 + net_.numOutputs(c); q++)
+			arrival_[net_.outputNet(q)] = pinArrival(q);
+	}
+	findCritical();
+
+	// longest paths to the outputs, backwards
+	// (required times are Treq minus these)
+	down_.assign(N, DELAY_T_MIN);
+	for (int k = C-1; k >= 0; k--)
+	{
+		int c = order_[k];
+		int q0 = net_.firstOutput(c);
+		for (int q = q0; q < q0 + net_.numOutputs(c); q++)
+			down_[net_.outputNet(q)] = netDown(net_.outputNet(q));
+	}
+	for (int n = 0; n < N; n++)
+		if (writer_[n] < 0)
+			down_[n] = netDown(n);
+}
+
+delay_t StaticTiming::inputSlack(int i) const
+{
+	assert(i >= 0 && i < (int)topIn_.size());
+	return (topIn_[i] < 0) ? DELAY_T_MAX : slack(topIn_[i]);
+}
+
+delay_t StaticTiming::outputArrival(int o) const
+{
+	assert(o >= 0 && o < (int)topOut_.size());
+	return (topOut_[o] < 0) ? DELAY_T_MIN : arrival_[topOut_[o]];
+}
+
+delay_t StaticTiming::criticalPath(int* inum_p, int* onum_p) const
+{
+	int i_max = -1, o_max = -1;
+	if (Tcrit_ != DELAY_T_MIN)
+	{
+		// first input on a critical path
+		for (size_t i = 0; i < topIn_.size() && i_max < 0; i++)
+			if (topIn_[i] >= 0 && writer_[topIn_[i]] < 0 && down_[topIn_[i]] == Tcrit_)
+				i_max = i;
+		assert(i_max >= 0);
+
+		// Nets on critical paths from it: an arc is on one if it keeps
+		// arrival + down at Tcrit, and the critical outputs have down 0.
+		std::set<int> critical;
+		std::vector<int> stack(1, topIn_[i_max]);
+		critical.insert(topIn_[i_max]);
+		while (!stack.empty())
+		{
+			int n = stack.back();
+			stack.pop_back();
+			const std::vector<int>& readers = readers_[n];
+			for (size_t r = 0; r < readers.size(); r++)
+			{
+				int p = readers[r];
+				for (int a = arcStart_[p]; a < arcStart_[p+1]; a++)
+				{
+					if (arcDelay_[a] <= 0) continue;
+					int q = arcOut_[a];
+					int m = net_.outputNet(q);
+					if (down_[m] == DELAY_T_MIN || down_[m] + arcTotal(arcDelay_[a], q) != down_[n]) continue;
+					if (critical.insert(m).second) stack.push_back(m);
+				}
+			}
+		}
+
+		// first critical output reached from it
+		for (size_t o = 0; o < topOut_.size() && o_max < 0; o++)
+			if (topOut_[o] >= 0 && down_[topOut_[o]] == 0 && critical.count(topOut_[o]))
+				o_max = o;
+		assert(o_max >= 0);
+	}
+
+	if (inum_p) *inum_p = i_max;
+	if (onum_p) *onum_p = o_max;
+	return Tcrit_;
+}
+
+////////////////////////////////////////////////////////////
+// Incremental updates
+////////////////////////////////////////////////////////////
+
+void StaticTiming::setDelay(int c, int inum, int onum, delay_t d)
+{
+	assert(c >= 0 && c < net_.numCells());
+	assert(inum >= 0 && inum < net_.numInputs(c));
+	assert(onum >= 0 && onum < net_.numOutputs(c));
+	int a = findArc(c, inum, onum);
+	if (a < 0)
+	{
+		// big cells only have the arcs of the Netlist
+		assert(d == DELAY_T_MIN);
+		return;
+	}
+	if (arcDelay_[a] == d) return;
+	int p = net_.firstInput(c) + inum;
+	bool timed = isTimed(p);
+	arcDelay_[a] = d;
+
+	// arrivals after the cell, and down before the input
+	dirtyCells_.push_back(c);
+	int n = inNet_[p];
+	if (n >= 0) dirtyNets_.push_back(n);
+
+	// a newly timed input: the cell must come after its driver
+	if (!timed && isTimed(p) && n >= 0 && writer_[n] >= 0 && !loops_ && !relevel_)
+		if (!raiseLevel(c, level_[pinCell_[writer_[n]]] + 1))
+			relevel_ = true;
+}
+
+delay_t StaticTiming::getDelay(int c, int inum, int onum) const
+{
+	assert(c >= 0 && c < net_.numCells());
+	assert(inum >= 0 && inum < net_.numInputs(c));
+	assert(onum >= 0 && onum < net_.numOutputs(c));
+	int a = findArc(c, inum, onum);
+	return (a < 0) ? DELAY_T_MIN : arcDelay_[a];
+}
+
+void StaticTiming::addLoad(int n, delay_t load)
+{
+	int q = writer_[n];
+	if (q < 0 || load == 0) return;
+	fanout_[q] += load;
+
+	// every arc into the writer's output changes
+	int c = pinCell_[q];
+	dirtyCells_.push_back(c);
+	int p0 = net_.firstInput(c);
+	for (int p = p0; p < p0 + net_.numInputs(c); p++)
+		if (inNet_[p] >= 0)
+			dirtyNets_.push_back(inNet_[p]);
+}
+
+void StaticTiming::replaceCell(int c, Module& m)
+{
+	assert(c >= 0 && c < net_.numCells());
+	assert(m.numInputs() == net_.numInputs(c));
+	assert(m.numOutputs() == net_.numOutputs(c));
+
+	int p0 = net_.firstInput(c);
+	for (int i = 0; i < m.numInputs(); i++)
+	{
+		for (int o = 0; o < m.numOutputs(); o++)
+			setDelay(c, i, o, m.delay(i,o));
+
+		delay_t load = m.load(i);
+		if (inNet_[p0+i] >= 0)
+			addLoad(inNet_[p0+i], load - load_[p0+i]);
+		load_[p0+i] = load;
+	}
+}
+
+void StaticTiming::connect(int c, int inum, int n)
+{
+	assert(c >= 0 && c < net_.numCells());
+	assert(inum >= 0 && inum < net_.numInputs(c));
+	assert(n >= -1 && n < net_.numNets());
+	int p = net_.firstInput(c) + inum;
+	int old = inNet_[p];
+	if (old == n) return;
+
+	if (old >= 0)
+	{
+		std::vector<int>& readers = readers_[old];
+		readers.erase(std::find(readers.begin(), readers.end(), p));
+		addLoad(old, -load_[p]);
+		dirtyNets_.push_back(old);
+	}
+	inNet_[p] = n;
+	if (n >= 0)
+	{
+		readers_[n].push_back(p);
+		addLoad(n, load_[p]);
+		dirtyNets_.push_back(n);
+
+		// the cell must stay after its new driver
+		if (writer_[n] >= 0 && isTimed(p) && !loops_ && !relevel_)
+			if (!raiseLevel(c, level_[pinCell_[writer_[n]]] + 1))
+				relevel_ = true;
+	}
+	dirtyCells_.push_back(c);
+}
+
+int StaticTiming::update()
+{
+	if (dirtyCells_.empty() && dirtyNets_.empty() && !relevel_)
+		return 0;
+
+	// new loops (or old ones) need the full analysis
+	if (relevel_ || loops_)
+	{
+		analyze(Tset_);
+		return net_.numCells() + net_.numNets();
+	}
+	int count = 0;
+	typedef std::pair<int,int> ITEM_T;
+
+	// arrival times forwards, lowest level first
+	std::priority_queue<ITEM_T, std::vector<ITEM_T>, std::greater<ITEM_T> > cells;
+	for (size_t k = 0; k < dirtyCells_.size(); k++)
+	{
+		int c = dirtyCells_[k];
+		if (cellQueued_[c]) continue;
+		cellQueued_[c] = 1;
+		cells.push(ITEM_T(level_[c], c));
+	}
+	while (!cells.empty())
+	{
+		int c = cells.top().second;
+		cells.pop();
+		cellQueued_[c] = 0;
+		count++;
+
+		int q0 = net_.firstOutput(c);
+		for (int q = q0; q < q0 + net_.numOutputs(c); q++)
+		{
+			int n = net_.outputNet(q);
+			delay_t T = pinArrival(q);
+			if (T == arrival_[n]) continue;
+			arrival_[n] = T;
+
+			const std::vector<int>& readers = readers_[n];
+			for (size_t r = 0; r < readers.size(); r++)
+			{
+				int c2 = inCell_[readers[r]];
+				if (cellQueued_[c2]) continue;
+				cellQueued_[c2] = 1;
+				cells.push(ITEM_T(level_[c2], c2));
+			}
+		}
+	}
+
+	// longest paths to the outputs backwards, highest writer level first
+	std::priority_queue<ITEM_T> nets;
+	for (size_t k = 0; k < dirtyNets_.size(); k++)
+	{
+		int n = dirtyNets_[k];
+		if (netQueued_[n]) continue;
+		netQueued_[n] = 1;
+		nets.push(ITEM_T(writer_[n] < 0 ? -1 : level_[pinCell_[writer_[n]]], n));
+	}
+	while (!nets.empty())
+	{
+		int n = nets.top().second;
+		nets.pop();
+		netQueued_[n] = 0;
+		count++;
+
+		delay_t D = netDown(n);
+		if (D == down_[n]) continue;
+		down_[n] = D;
+
+		int q = writer_[n];
+		if (q < 0) continue;
+		for (int k = revStart_[q]; k < revStart_[q+1]; k++)
+		{
+			int a = revArc_[k];
+			int n2 = inNet_[arcIn_[a]];
+			if (n2 < 0 || netQueued_[n2] || arcDelay_[a] <= 0) continue;
+			netQueued_[n2] = 1;
+			nets.push(ITEM_T(writer_[n2] < 0 ? -1 : level_[pinCell_[writer_[n2]]], n2));
+		}
+	}
+
+	dirtyCells_.clear();
+	dirtyNets_.clear();
+	findCritical();
+	return count;
+}
+
+////////////////////////////////////////////////////////////
+// Path enumeration
+////////////////////////////////////////////////////////////
+
+// a partial path, from a net to the output (a stage and the rest of the path)
+struct PathNode
+{
+	int net;
+	// suffix delay from the net to the output
+	delay_t suffix;
+	// the stage that reads `net` (output pin and arc delay), and the next node
+	int inpin, outpin;
+	delay_t delay;
+	int next;
+};
+
+// (bound, node) with the longest bound first, and the oldest node on ties
+struct PathEntry
+{
+	delay_t bound;
+	int node;
+	bool operator<(const PathEntry& other) const
+	{
+		if (bound != other.bound) return bound < other.bound;
+		return node > other.node;
+	}
+};
+
+void StaticTiming::outputPaths(int o, int K, delay_t Tmin, std::vector<TimingPath>& paths) const
+{
+	paths.clear();
+	// a path around a loop could go on forever
+	if (loops_) return;
+	int nout = topOut_[o];
+	if (nout < 0 || arrival_[nout] == DELAY_T_MIN || arrival_[nout] < Tmin) return;
+
+	// Best-first search backwards from the output.
+	// The arrival time of a net is its longest path from an input, so
+	// arrival + suffix is exactly the longest path through a partial path,
+	// and complete paths come out longest first.
+	std::vector<PathNode> nodes;
+	std::priority_queue<PathEntry> heap;
+	PathNode start = {nout, 0, -1, -1, 0, -1};
+	nodes.push_back(start);
+	PathEntry e0 = {arrival_[nout], 0};
+	heap.push(e0);
+
+	while (!heap.empty() && (int)paths.size() < K)
+	{
+		PathEntry e = heap.top();
+		heap.pop();
+		if (e.bound < Tmin) break;
+		PathNode node = nodes[e.node];
+
+		// reached an input: the path is complete
+		if (netIn_[node.net] >= 0 && writer_[node.net] < 0)
+		{
+			TimingPath path;
+			path.input = netIn_[node.net];
+			path.output = o;
+			path.delay = node.suffix;
+			delay_t T = 0;
+			for (int k = e.node; nodes[k].next >= 0; k = nodes[k].next)
+			{
+				const PathNode& s = nodes[k];
+				int c = pinCell_[s.outpin];
+				TimingStage stage;
+				stage.cell = c;
+				stage.inum = s.inpin - net_.firstInput(c);
+				stage.onum = s.outpin - net_.firstOutput(c);
+				stage.delay = s.delay;
+				T += s.delay;
+				stage.arrival = T;
+				path.stages.push_back(stage);
+			}
+			paths.push_back(path);
+			continue;
+		}
+
+		// extend through every arc into the writer of this net
+		int q = writer_[node.net];
+		if (q < 0) continue;
+		for (int k = revStart_[q]; k < revStart_[q+1]; k++)
+		{
+			int a = revArc_[k];
+			int p = arcIn_[a];
+			int n = inNet_[p];
+			if (n < 0 || arrival_[n] == DELAY_T_MIN || arcDelay_[a] <= 0) continue;
+			delay_t d = arcTotal(arcDelay_[a], q);
+			PathNode next = {n, node.suffix + d, p, q, d, e.node};
+			PathEntry en = {arrival_[n] + next.suffix, (int)nodes.size()};
+			nodes.push_back(next);
+			heap.push(en);
+		}
+	}
+}
+
+// arguments of outputTask
+struct PathTask
+{
+	const StaticTiming* sta;
+	int K;
+	delay_t Tmin;
+	std::vector< std::vector<TimingPath> >* paths;
+};
+
+// static method
+void StaticTiming::outputTask(void* arg, int o, int w)
+{
+	PathTask* task = static_cast<PathTask*>(arg);
+	task->sta->outputPaths(o, task->K, task->Tmin, (*task->paths)[o]);
+}
+
+// longest first, then in (input,output) order
+static bool longerPath(const TimingPath& p1, const TimingPath& p2)
+{
+	if (p1.delay != p2.delay) return p1.delay > p2.delay;
+	if (p1.input != p2.input) return p1.input < p2.input;
+	return p1.output < p2.output;
+}
+
+void StaticTiming::topPaths(int K, std::vector<TimingPath>& paths) const
+{
+	assert(K > 0);
+	paths.clear();
+
+	// The output cones are searched independently.
+	// Each output has a path as long as its arrival time, so the K-th longest
+	// arrival is a lower bound for the K-th longest path, and shorter paths
+	// (or outputs) are skipped.
+	int Nout = topOut_.size();
+	std::vector<delay_t> arrivals;
+	for (int o = 0; o < Nout; o++)
+		if (outputArrival(o) != DELAY_T_MIN)
+			arrivals.push_back(outputArrival(o));
+	delay_t Tmin = DELAY_T_MIN;
+	if ((int)arrivals.size() >= K)
+	{
+		std::nth_element(arrivals.begin(), arrivals.begin() + (K-1), arrivals.end(), std::greater<delay_t>());
+		Tmin = arrivals[K-1];
+	}
+
+	std::vector< std::vector<TimingPath> > perOutput(Nout);
+	PathTask task = {this, K, Tmin, &perOutput};
+	if (threads_ > 1 && Nout > 1)
+	{
+		WorkPool pool(threads_);
+		pool.run(Nout, outputTask, &task);
+	}
+	else
+	{
+		for (int o = 0; o < Nout; o++)
+			outputTask(&task, o, 0);
+	}
+
+	// merge them
+	for (int o = 0; o < Nout; o++)
+		paths.insert(paths.end(), perOutput[o].begin(), perOutput[o].end());
+	std::stable_sort(paths.begin(), paths.end(), longerPath);
+	if ((int)paths.size() > K)
+		paths.resize(K);
+}
+
+void StaticTiming::printPath(std::ostream& out, const TimingPath& path) const
+{
+	Module* top = net_.top();
+	out << "path " << top->nameOfInput(path.input) << " -> " << top->nameOfOutput(path.output)
+	    << ": delay " << path.delay << std::endl;
+	for (size_t k = 0; k < path.stages.size(); k++)
+	{
+		const TimingStage& s = path.stages[k];
+		Module* m = net_.cell(s.cell);
+		out << "  " << *m << " " << m->nameOfInput(s.inum) << " -> " << m->nameOfOutput(s.onum)
+		    << "  +" << s.delay << " = " << s.arrival << std::endl;
+	}
+}
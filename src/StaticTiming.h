@@ -0,0 +1,209 @@
+#ifndef STATICTIMING_H_
+#define STATICTIMING_H_
+
+#include <vector>
+#include <ostream>
+#include "Netlist.h"
+#include "param.h"
+
+// one stage of a timing path: an arc through a cell
+struct TimingStage
+{
+	// cell number in the Netlist, and input/output number within the cell
+	int cell;
+	int inum, onum;
+	// arc delay (including the fanout of the output)
+	delay_t delay;
+	// arrival time at the output
+	delay_t arrival;
+};
+
+// a path from a top-level input to a top-level output
+struct TimingPath
+{
+	int input, output;
+	delay_t delay;
+	std::vector<TimingStage> stages;
+};
+
+// Static timing analysis of a Netlist.
+// Delays are the same as in simulation and Module::criticalPath(): each arc
+// with a positive delay(i,o) costs that delay plus the fanout of the output.
+// The cells are visited once in level order, so the arrival time of every net
+// (longest path from any top-level input) is computed in O(V+E), and the
+// required times in one more pass backwards. Levels only follow the inputs
+// with a timing arc, so registers (whose D input has none) break feedback
+// loops. Cells in other (combinational) loops are visited once, in no
+// particular order, and there are no paths (see topPaths) in such designs.
+//
+// Nets that can't be reached from a top-level input have arrival DELAY_T_MIN,
+// and nets that can't reach a top-level output have required time DELAY_T_MAX.
+//
+// The timing graph can be edited (delays of single instances, connections
+// and whole cells) without changing the Netlist or its modules. update()
+// then re-propagates arrival times only through the fan-out cones of the
+// edits, and required times only through their fan-in cones.
+class StaticTiming
+{
+private:
+	const Netlist& net_;
+	// cells in level order (valid after analyze())
+	std::vector<int> order_;
+	std::vector<int> level_;
+	bool loops_;
+
+	// net of each top-level input/output (-1 if none)
+	std::vector<int> topIn_;
+	std::vector<int> topOut_;
+	// top-level input of each net (-1 if none)
+	std::vector<int> netIn_;
+	// is each net a top-level output?
+	std::vector<char> netOut_;
+	// output pin that writes each net (-1 if none)
+	std::vector<int> writer_;
+	// cell of each input/output pin
+	std::vector<int> inCell_;
+	std::vector<int> pinCell_;
+
+	// editable copies of the Netlist:
+	// net and load of each input pin, readers (input pins) of each net,
+	// and fanout of each output pin
+	std::vector<int> inNet_;
+	std::vector<delay_t> load_;
+	std::vector< std::vector<int> > readers_;
+	std::vector<delay_t> fanout_;
+	// arcs (input pin, output pin, delay) of input pin p are
+	// [arcStart_[p],arcStart_[p+1]), and the arcs into output pin q are
+	// revArc_[revStart_[q]..revStart_[q+1]-1]
+	// small cells have every (input,output) pair, so any delay can be set
+	std::vector<int> arcStart_;
+	std::vector<int> arcIn_;
+	std::vector<int> arcOut_;
+	std::vector<delay_t> arcDelay_;
+	std::vector<int> revStart_;
+	std::vector<int> revArc_;
+
+	// arrival time of each net, and longest path from each net to an output
+	std::vector<delay_t> arrival_;
+	std::vector<delay_t> down_;
+	delay_t Tcrit_;
+	delay_t Treq_;
+	// the Treq given to analyze()
+	delay_t Tset_;
+
+	// edits since the last update: cells with changed arcs, nets with
+	// changed readers, and whether the levels are no longer valid
+	std::vector<int> dirtyCells_;
+	std::vector<int> dirtyNets_;
+	bool relevel_;
+	// cells and nets queued by update()
+	std::vector<char> cellQueued_;
+	std::vector<char> netQueued_;
+
+	// threads used by topPaths()
+	int threads_;
+
+	StaticTiming(const StaticTiming&);
+	StaticTiming& operator=(const StaticTiming&);
+
+	// delay of the arc to output pin q (with fanout)
+	inline delay_t arcTotal(delay_t d, int q) const
+	{
+#if USE_FANOUT_DELAY
+		return d + fanout_[q];
+#else
+		return d;
+#endif
+	}
+
+	// arc from input inum to output onum of cell c (-1 if none)
+	int findArc(int c, int inum, int onum) const;
+	// does input pin p have an arc with a positive delay?
+	bool isTimed(int p) const;
+
+	// sort the cells by level with the edited connections
+	void levelize();
+	// raise the levels after cell c so they come after level L
+	bool raiseLevel(int c, int L);
+	// arrival time at output pin q, and longest path from net n to an output
+	delay_t pinArrival(int q) const;
+	delay_t netDown(int n) const;
+	// add a load to the fanout of net n
+	void addLoad(int n, delay_t load);
+	// find the critical delay over the outputs
+	void findCritical();
+
+	// up to K longest paths that end at top-level output o (longest first),
+	// without the ones shorter than Tmin
+	void outputPaths(int o, int K, delay_t Tmin, std::vector<TimingPath>& paths) const;
+	static void outputTask(void* arg, int o, int w);
+
+public:
+	// threads are used for the paths of different outputs
+	StaticTiming(const Netlist& net, int threads=1);
+
+	// compute arrival times, and required times for outputs required at Treq
+	// (DELAY_T_MIN means at the critical delay, so the worst slack is 0)
+	void analyze(delay_t Treq=DELAY_T_MIN);
+
+	// longest path delay (DELAY_T_MIN if no output can be reached)
+	inline delay_t criticalDelay() const { return Tcrit_; }
+	// the time outputs are required at
+	inline delay_t requiredTime() const { return Treq_; }
+
+	// per-net times
+	inline delay_t arrival(int n) const { return arrival_[n]; }
+	inline delay_t required(int n) const
+	{
+		if (down_[n] == DELAY_T_MIN || Treq_ == DELAY_T_MIN) return DELAY_T_MAX;
+		return Treq_ - down_[n];
+	}
+	inline delay_t slack(int n) const
+	{
+		if (arrival_[n] == DELAY_T_MIN) return DELAY_T_MAX;
+		delay_t R = required(n);
+		if (R == DELAY_T_MAX) return DELAY_T_MAX;
+		return R - arrival_[n];
+	}
+
+	// per top-level port times (DELAY_T_MIN if not reachable)
+	delay_t inputSlack(int i) const;
+	delay_t outputArrival(int o) const;
+
+	// critical path delay and its (input,output) pair, chosen like
+	// Module::criticalPath() (the first pair in (input,output) order)
+	// only the nets on critical paths are visited
+	delay_t criticalPath(int* inum_p=NULL, int* onum_p=NULL) const;
+
+	// the K longest paths over all outputs (longest first)
+	// each output's paths are found separately (in parallel with threads)
+	// (none if there are loops)
+	void topPaths(int K, std::vector<TimingPath>& paths) const;
+
+	// print a path, one stage per line
+	void printPath(std::ostream& out, const TimingPath& path) const;
+
+	// edits (the times are not valid again until update())
+	// delay of cell c from input inum to output onum
+	// (DELAY_T_MIN removes the arc, and cells with more than MAX_DENSE_ARCS
+	// input/output pairs can only change the arcs they have)
+	enum { MAX_DENSE_ARCS = 64 };
+	void setDelay(int c, int inum, int onum, delay_t d);
+	delay_t getDelay(int c, int inum, int onum) const;
+	// use the delays and loads of leaf module m for cell c
+	// (m must have the same number of inputs and outputs)
+	void replaceCell(int c, Module& m);
+	// connect input inum of cell c to net n (-1 disconnects it)
+	void connect(int c, int inum, int n);
+	inline int inputNet(int c, int inum) const { return inNet_[net_.firstInput(c) + inum]; }
+
+	// propagate the edits
+	// returns the number of cells and nets whose times were recomputed
+	int update();
+
+	// levelization info
+	inline int level(int c) const { return level_[c]; }
+	inline bool hasLoops() const { return loops_; }
+};
+
+#endif // STATICTIMING_H_
@@ -1,10 +1,15 @@
 #ifdef DEBUG
 #include <iostream>
 #endif
+#include <pthread.h>
 #include <cstdarg>
 #include <queue>
+#include <set>
+#include <algorithm>
 #include "SystemModule.h"
 #include "Wire.h"
+#include "Netlist.h"
+#include "StaticTiming.h"
 #include "param.h"
 
 void SystemModule::reset()
@@ -14,28 +19,34 @@ void SystemModule::reset()
 		(*iter)->reset();
 }
 
-void clearDelayTables()
+void SystemModule::finalize()
 {
-	SystemModule::delayTables.clear();
+	// finalize all submodules
+	for (MITER_T iter = submodules_.begin(); iter != submodules_.end(); iter++)
+		(*iter)->finalize();
 }
 
 // should only be called if `this` is root module at the start of a simulation
 void SystemModule::propagate()
 {
 #ifdef DEBUG
-std::cout << "system propagate " << *this << " T=" << simtime << std::endl;
+std::cout << "system propagate " << *this << " T=" << simTime() << std::endl;
 #endif
-	assert(simtime == 0);
-	MSET_T modules;
+	assert(simTime() == 0);
+	std::vector<Module*> modules;
 
 	// gather all submodules connected to inputs
 	for (int i = 0; i < numInputs(); i++)
 		if (Wire* w = inWires_[i])
 			for (PORTITER_T iter = w->beginReaders(); iter != w->endReaders(); iter++)
-				modules.insert((*iter).first);
+				modules.push_back((*iter).first);
+
+	// each submodule is propagated once (in the same order as an MSET_T)
+	std::sort(modules.begin(), modules.end());
+	modules.erase(std::unique(modules.begin(), modules.end()), modules.end());
 
 	// propagate all submodules
-	for (MITER_T iter = modules.begin(); iter != modules.end(); iter++)
+	for (std::vector<Module*>::iterator iter = modules.begin(); iter != modules.end(); iter++)
 		(*iter)->propagate();
 }
 
@@ -74,28 +85,6 @@ std::cout << "connect " << *this << " output " << onum << " to " << *other << "
 	}
 }
 
-void SystemModule::mergeInputWire(int inum, Wire* w)
-{
-	assert(w);
-	assert(inum >= 0 && inum < numInputs());
-	assert(inWires_[inum]);
-
-	// Problem: we want to call merge on direct submodules, but wire readers are only `leaf` modules.
-	// Solution: keep track of direct submodules and recursively merge on them.
-	for (MITER_T iter = submodules_.begin(); iter != submodules_.end(); iter++)
-	{
-		Module* m = (*iter);
-		int Nin = m->numInputs();
-		for (int i = 0; i < Nin; i++)
-			if (m->inWires_[i] == inWires_[inum])
-				m->mergeInputWire(i, w);
-	}
-
-	// replace in our own wire array
-	inWires_[inum]->release();
-	inWires_[inum] = w->retain();
-}
-
 void SystemModule::connectSystemInput(int i, Module* m, int inum)
 {
 	assert(i >= 0 && i < numInputs());
@@ -116,6 +105,7 @@ std::cout << "system " << *this << " input" << i << " " << nameOfInput(i) << " g
 		{
 			// neither wire exists yet
 			inWires_[i] = w1 = new Wire();
+			w1->addAlias(this, i);
 			m->inWires_[inum] = w1->retain();
 			assert(!m->isSystem());
 			w1->addReader(m, inum);
@@ -124,6 +114,7 @@ std::cout << "system " << *this << " input" << i << " " << nameOfInput(i) << " g
 		{
 			// other wire exists but ours doesn't
 			inWires_[i] = w2->retain();
+			w2->addAlias(this, i);
 		}
 	}
 	else if (w2 == NULL)
@@ -271,6 +262,26 @@ void SystemModule::submodule(Module* m)
 #endif
 }
 
+// interned group names (never freed)
+static std::set<std::string> groupNames;
+static pthread_mutex_t groupLock = PTHREAD_MUTEX_INITIALIZER;
+
+void SystemModule::submodule(Module* m, const std::string& group)
+{
+	submodule(m);
+	pthread_mutex_lock(&groupLock);
+	const std::string* name = &*groupNames.insert(group).first;
+	pthread_mutex_unlock(&groupLock);
+	groups_.push_back(std::make_pair(m, name));
+}
+
+const std::string& SystemModule::group(Module* m) const
+{
+	for (size_t k = 0; k < groups_.size(); k++)
+		if (groups_[k].first == m) return *groups_[k].second;
+	return m->classname();
+}
+
 void SystemModule::submodules(int Nmod, Module* m, ...)
 {
 	va_list vlist;
@@ -288,16 +299,13 @@ void SystemModule::submodules(int Nmod, Module* m, ...)
 	va_end(vlist);
 }
 
-// definition for static variable
-SystemModule::DELAYMAP_T SystemModule::delayTables;
-
 // generate and return a table for this module
-SystemModule::DELAYTBL_T* SystemModule::generateDelayTable()
+const SystemModule::DELAYTBL_T* SystemModule::generateDelayTable()
 {
 	// classname must be defined
-	assert(classname_.length() > 0);
+	assert(classname().length() > 0);
 #ifdef DEBUG
-std::cout << "generateDelayTable " << classname_ << std::endl;
+std::cout << "generateDelayTable " << classname() << std::endl;
 std::cout << "we have " << submodules_.size() << " submodules" << std::endl;
 #endif
 
@@ -389,14 +397,19 @@ std::cout << "        processing delays through submodule " << *m << " input " <
 				Wire* ow = m->outWires_[onum];
 				if (!ow) continue;
 				IWPAIR_T iwpair(sysinum,ow);
-				wirequeue.push(iwpair);
 				// wire `w` is reachable from system input `sysinum`
 				// therefore wire `ow` is also reachable
 				// input `sysinum` can reach `ow` in time `dT + delaytowire[inum,w]`
 				// set delaytowire[inum,ow] to that time (if its bigger than existing)
 				delay_t& TtoOW = delaytowire[iwpair]; // (item created with value 0 if doesn't exist yet)
 				delay_t T = TtoW + dT;
-				if (T > TtoOW) TtoOW = T;
+				// only process `ow` again if its delay got longer
+				// (otherwise reconvergent paths are followed over and over)
+				if (T > TtoOW)
+				{
+					TtoOW = T;
+					wirequeue.push(iwpair);
+				}
 			}
 		}
 	}
@@ -440,9 +453,8 @@ std::cout << "    " << delaytowire.size() << " (i,w) pairs in delaytowire" << st
 #ifdef DEBUG
 std::cout << "    " << dtbl->size() << " (I,O) pairs in delay table" << std::endl;
 #endif
-	// save delay table in global cache, and return it
-	delayTables[classname_] = dtbl;
-	return dtbl;
+	// save delay table in the cache, and return the cached one
+	return DelayCache::global().add(classname(), dtbl);
 }
 
 // only used for computing critical path
@@ -455,9 +467,9 @@ delay_t SystemModule::delay(int inum, int onum)
 std::cout << "SystemModule::delay(" << inum << "," << onum << ") " << *this << std::endl;
 #endif
 	// get delay table for particular module type
-	assert(classname_.length() > 0);
-	DMAPITER_T iter_m = delayTables.find(classname_);
-	DELAYTBL_T* dtbl = (iter_m == delayTables.end()) ? generateDelayTable() : (*iter_m).second;
+	assert(classname().length() > 0);
+	const DELAYTBL_T* dtbl = DelayCache::global().find(classname());
+	if (dtbl == NULL) dtbl = generateDelayTable();
 
 	// look up I->O delay
 	DTBLITER_T iter = dtbl->find(IOPAIR_T(inum,onum));
@@ -466,6 +478,51 @@ std::cout << "SystemModule::delay(" << inum << "," << onum << ") " << *this << s
 	return (*iter).second;
 }
 
+delay_t SystemModule::criticalPath(int* inum_p, int* onum_p)
+{
+	assert(classname().length() > 0);
+	const DELAYTBL_T* dtbl = DelayCache::global().find(classname());
+
+	// without a table, static timing of the flattened design is much faster
+	// than generating one (unless it has combinational loops)
+	if (dtbl == NULL && Netlist::canFlatten(*this))
+	{
+		Netlist nl(*this);
+		StaticTiming sta(nl);
+		if (sta.criticalDelay() != DELAY_T_MIN && !sta.hasLoops())
+			return sta.criticalPath(inum_p, onum_p);
+	}
+	if (dtbl == NULL) dtbl = generateDelayTable();
+	if (dtbl->empty()) return Module::criticalPath(inum_p, onum_p);
+
+	// find the max delay for the (input,output) pairs in the table
+	// (in the same order as Module::criticalPath)
+	delay_t Tmax = DELAY_T_MIN;
+	int i_max = -1, o_max = -1;
+	std::vector<delay_t> fanouts(numOutputs());
+	for (int onum = 0; onum < numOutputs(); onum++)
+		fanouts[onum] = fanout(onum);
+	for (DTBLITER_T iter = dtbl->begin(); iter != dtbl->end(); iter++)
+	{
+		int inum = (*iter).first.first;
+		int onum = (*iter).first.second;
+		delay_t T = (*iter).second;
+#if USE_FANOUT_DELAY
+		T += fanouts[onum];
+#endif
+		if (T > Tmax)
+		{
+			Tmax = T;
+			i_max = inum;
+			o_max = onum;
+		}
+	}
+
+	if (inum_p) *inum_p = i_max;
+	if (onum_p) *onum_p = o_max;
+	return Tmax;
+}
+
 // sum the area of all submodules
 area_t SystemModule::area() const
 {
@@ -2,6 +2,8 @@
 #define SYSTEMMODULE_H_
 
 #include "Module.h"
+#include "SimContext.h"
+#include "DelayCache.h"
 
 // A SystemModule is a Module which contains other Modules.
 // All cumulative delay/area/load/energy calculations are done here.
@@ -13,16 +15,16 @@ protected:
 	MSET_T submodules_;
 
 private:
-	// lazily-created delay tables
-	typedef std::pair<int,int> IOPAIR_T;
-	typedef std::map<IOPAIR_T,delay_t> DELAYTBL_T;
-	typedef DELAYTBL_T::iterator DTBLITER_T;
-	typedef std::map<std::string,DELAYTBL_T*> DELAYMAP_T;
-	typedef DELAYMAP_T::iterator DMAPITER_T;
-	// cache of delays for all used module types
-	static DELAYMAP_T delayTables;
+	// report group of the submodules that have one (see PowerReport)
+	// (the names are interned, so each one is stored once)
+	std::vector< std::pair<Module*,const std::string*> > groups_;
+
+	// lazily-created delay tables (cached in the DelayCache)
+	typedef DelayCache::IOPAIR_T IOPAIR_T;
+	typedef DelayCache::DELAYTBL_T DELAYTBL_T;
+	typedef DELAYTBL_T::const_iterator DTBLITER_T;
 	// helper function that generates table
-	DELAYTBL_T* generateDelayTable();
+	const DELAYTBL_T* generateDelayTable();
 
 	// helper function adds energies for submodules
 	void recordEnergies(std::map<delay_t,energy_t>& energyTable) const;
@@ -37,9 +39,16 @@ public:
 	// overridden from Module
 	void reset();
 
+	// overridden from Module
+	void finalize();
+
 	// overridden from Module
 	delay_t delay(int inum, int onum);
 
+	// overridden from Module
+	// (uses the cached delay table, or else times the flattened design)
+	delay_t criticalPath(int* inum_p=NULL, int* onum_p=NULL);
+
 	// overridden from Module
 	delay_t load(int inum) const;
 
@@ -49,16 +58,19 @@ public:
 	// overridden from Module
 	energy_t energy(int onum) const;
 
+	// report group of submodule m (its classname unless given)
+	// (searches the submodules with a group)
+	const std::string& group(Module* m) const;
+
 protected:
 	// overridden from Module
 	void propagate();
 
-	// overridden from Module
-	void mergeInputWire(int inum, Wire* w);
-
 	// register submodule(s) for delay/area computations (and set `parent`)
 	void submodule(Module* m);
 	void submodules(int Nmod, Module* m, ...);
+	// same, and report it in the given group (instead of with its class)
+	void submodule(Module* m, const std::string& group);
 
 	// connect system input/output with sub-module
 	void connectSystemInput(int i, Module* m, int inum);
@@ -67,7 +79,8 @@ protected:
 	// operators need protected access
 	friend void operator>>(const Port&, const Port&);
 	friend void operator<<(const Port&, const Port&);
-	friend void clearDelayTables();
+	friend class Netlist;
+	friend class PowerReport;
 };
 
 #endif // SYSTEMMODULE_H_
@@ -11,6 +11,8 @@
 // Write a VCD file to a stream.
 // A VCD file is a text file that lists signals and their values at the times when they changed.
 // VCDs can be opened in waveform viewer applications.
+// Signals can be added before or after simulating, but in streaming mode
+// (see Module::simUseHistory) they must be added before.
 class VCDWriter
 {
 private:
@@ -22,22 +24,34 @@ private:
 	typedef std::set<int> INTSET_T;
 	std::map<delay_t,INTSET_T> changelist_;
 
-	// add all changes to `changelist_`
-	void processNewSignal(std::string name, const Port& p)
+	// add a signal (its history is read when the file is written)
+	void processNewSignal(std::string name, Port p)
 	{
-		int N = mports_.size();
 		mports_.push_back(p);
 		name.erase(std::remove(name.begin(), name.end(), ' '), name.end());
 		names_.push_back(name);
 
-		for (int i = p.low; i <= p.high; i++)
+		// keep full history if the simulation is streaming
+		p.probe();
+	}
+
+	// add all changes to `changelist_`
+	void processChanges()
+	{
+		changelist_.clear();
+		int N = mports_.size();
+		for (int n = 0; n < N; n++)
 		{
-			const Wire* w = p.isOutput ? p.module->outputWire(i) : p.module->inputWire(i);
-			if (!w) continue;
-			for (HITER_T iter = w->histBegin(); iter != w->histEnd(); iter++)
+			const Port& p = mports_[n];
+			for (int i = p.low; i <= p.high; i++)
 			{
-				delay_t T = (*iter).first;
-				changelist_[T].insert(N);
+				const Wire* w = p.isOutput ? p.module->outputWire(i) : p.module->inputWire(i);
+				if (!w) continue;
+				for (HITER_T iter = w->histBegin(); iter != w->histEnd(); iter++)
+				{
+					delay_t T = (*iter).first;
+					changelist_[T].insert(n);
+				}
 			}
 		}
 	}
@@ -106,6 +120,7 @@ public:
 		os << "$end\n";
 
 		// dump signal changes
+		processChanges();
 		std::map<delay_t,INTSET_T>::const_iterator iter;
 		for (iter = changelist_.begin(); iter != changelist_.end(); iter++)
 		{
@@ -2,15 +2,18 @@
 #define WIRE_H_
 
 #include <set>
+#include <vector>
+#include <algorithm>
 #include <utility>
 #include <cassert>
 #include "BitHistory.h"
+#include "Pool.h"
 
 class Module;
 
 // Port is a (Module,i/o num) pair
 typedef std::pair<Module*,int> PORT_T;
-typedef std::set<PORT_T> PORTSET_T;
+typedef std::set<PORT_T, std::less<PORT_T>, PoolAllocator<PORT_T> > PORTSET_T;
 typedef PORTSET_T::const_iterator PORTITER_T;
 
 // A Wire represents a 1-bit connection between a writer Module and reader Modules.
@@ -23,25 +26,45 @@ private:
 	PORT_T writer_;
 	// many possible readers
 	PORTSET_T readers_;
+	// the same readers in one array, for simulation (see seal)
+	std::vector<PORT_T> readerArray_;
+	bool sealed_;
+	// system module inputs that hold this wire
+	// (they don't read it, but they must follow it when it is merged)
+	std::vector<PORT_T> aliases_;
 	// history of Bit values
 	BitHistory history_;
 	// hard-wired to a constant value
 	bool constant_;
+	// keep full history even when streaming
+	bool probed_;
 	// reference count
 	int refcnt_;
 
 public:
 	// constructor
-	Wire() : writer_(NULL,-1), constant_(false), refcnt_(1)
+	Wire() : writer_(NULL,-1), sealed_(false), constant_(false), probed_(false), refcnt_(1)
 	{
 	}
 
+	// wires are allocated from the Pool
+	static void* operator new(size_t n) { return Pool::alloc(n); }
+	static void operator delete(void* p, size_t n) { Pool::free(p, n); }
+
+	// bumped whenever a wire gets a reader or a writer
+	// (levelized copies of a module are rebuilt then, see Module::simLevelized)
+	static unsigned& structureVersion() { static unsigned v = 0; return v; }
+
 	// add reader
+	// (the writer's fanout changes, see Module::finalize)
 	void addReader(Module* m, int inum)
 	{
 		assert(m);
 		assert(inum >= 0 && inum < m->numInputs());
 		readers_.insert(PORT_T(m,inum));
+		sealed_ = false;
+		structureVersion()++;
+		if (writer_.first) writer_.first->readersChanged();
 	}
 
 	// add reader
@@ -50,6 +73,22 @@ public:
 		assert(p.first);
 		assert(p.second >= 0 && p.second < p.first->numInputs());
 		readers_.insert(p);
+		sealed_ = false;
+		structureVersion()++;
+		if (writer_.first) writer_.first->readersChanged();
+	}
+
+	// add/remove a system module input that holds this wire
+	void addAlias(Module* m, int inum)
+	{
+		assert(m);
+		aliases_.push_back(PORT_T(m,inum));
+	}
+
+	void removeAlias(Module* m, int inum)
+	{
+		std::vector<PORT_T>::iterator iter = std::find(aliases_.begin(), aliases_.end(), PORT_T(m,inum));
+		if (iter != aliases_.end()) aliases_.erase(iter);
 	}
 
 	// set writer
@@ -59,6 +98,8 @@ public:
 		assert(onum >= 0 && onum < m->numOutputs());
 		writer_.first = m;
 		writer_.second = onum;
+		structureVersion()++;
+		m->readersChanged();
 	}
 
 	// set writer
@@ -67,6 +108,8 @@ public:
 		assert(p.first);
 		assert(p.second >= 0 && p.second < p.first->numOutputs());
 		writer_ = p;
+		structureVersion()++;
+		p.first->readersChanged();
 	}
 
 	// mark as constant (hard-wired) value
@@ -78,14 +121,31 @@ public:
 		constant_ = true;
 	}
 
+	// always keep the full history of this wire
+	void probe() { probed_ = true; }
+
+	// copy the readers into one contiguous array
+	// (done before simulation; adding a reader unseals the wire)
+	void seal()
+	{
+		readerArray_.assign(readers_.begin(), readers_.end());
+		sealed_ = true;
+	}
+
 	// access to readers and writer
 	inline PORT_T& getWriter() { return writer_; }
 	inline PORTITER_T beginReaders() const { return readers_.begin(); }
 	inline PORTITER_T endReaders() const { return readers_.end(); }
+	inline const std::vector<PORT_T>& aliases() const { return aliases_; }
+	// sealed readers (in the same order)
+	inline const PORT_T* sealedReaders() const { assert(sealed_); return readerArray_.empty() ? NULL : &readerArray_[0]; }
 
 	// check status
 	inline bool hasWriter() const { return writer_.first != NULL; }
 	inline int numReaders() const { return (int)readers_.size(); }
+	inline bool isProbed() const { return probed_; }
+	inline bool isConstant() const { return constant_; }
+	inline bool isSealed() const { return sealed_; }
 
 	// get/set bit values
 	inline Bit get(delay_t T=DELAY_T_MAX) const { return history_.get(T); }
@@ -96,8 +156,11 @@ public:
 	inline delay_t lastTime() const { return history_.lastTime(); }
 	inline int numEdges() const { return history_.size(); }
 	inline void clear() { if (!constant_) history_.clear(); }
+	inline void forget(delay_t T) { if (!probed_) history_.forget(T); }
 	inline HITER_T histBegin() const { return history_.begin(); }
 	inline HITER_T histEnd() const { return history_.end(); }
+	// exchange history with another (used by compiled simulations)
+	inline void swapHistory(BitHistory& h) { history_.swap(h); }
 
 	// reference counting
 	Wire* retain() { refcnt_++; return this; }
@@ -0,0 +1,161 @@
+#include <cassert>
+#include "WorkPool.h"
+
+WorkPool::WorkPool(int Nworkers) :
+	 size_(Nworkers)
+	,ranges_(Nworkers)
+	,task_(0)
+	,arg_(0)
+	,gen_(0)
+	,busy_(0)
+	,quit_(false)
+{
+	assert(Nworkers > 0);
+	pthread_mutex_init(&lock_, NULL);
+	pthread_cond_init(&start_, NULL);
+	pthread_cond_init(&done_, NULL);
+	for (int w = 0; w < size_; w++)
+	{
+		pthread_mutex_init(&ranges_[w].lock, NULL);
+		ranges_[w].lo = ranges_[w].hi = 0;
+	}
+
+	// worker 0 is the caller of run()
+	threads_.resize(size_-1);
+	for (int w = 1; w < size_; w++)
+	{
+		Start* s = new Start;
+		s->pool = this;
+		s->w = w;
+		pthread_create(&threads_[w-1], NULL, thread, s);
+	}
+}
+
+WorkPool::~WorkPool()
+{
+	pthread_mutex_lock(&lock_);
+	quit_ = true;
+	pthread_cond_broadcast(&start_);
+	pthread_mutex_unlock(&lock_);
+	for (size_t t = 0; t < threads_.size(); t++)
+		pthread_join(threads_[t], NULL);
+
+	for (int w = 0; w < size_; w++)
+		pthread_mutex_destroy(&ranges_[w].lock);
+	pthread_cond_destroy(&done_);
+	pthread_cond_destroy(&start_);
+	pthread_mutex_destroy(&lock_);
+}
+
+int WorkPool::next(int w)
+{
+	// own work first
+	Range& mine = ranges_[w];
+	pthread_mutex_lock(&mine.lock);
+	if (mine.lo < mine.hi)
+	{
+		int i = mine.lo++;
+		pthread_mutex_unlock(&mine.lock);
+		return i;
+	}
+	pthread_mutex_unlock(&mine.lock);
+
+	// steal the upper half of another worker's indices
+	for (int k = 1; k < size_; k++)
+	{
+		Range& other = ranges_[(w+k) % size_];
+		pthread_mutex_lock(&other.lock);
+		int n = other.hi - other.lo;
+		if (n <= 0)
+		{
+			pthread_mutex_unlock(&other.lock);
+			continue;
+		}
+		int hi = other.hi;
+		other.hi -= (n+1) / 2;
+		int lo = other.hi;
+		pthread_mutex_unlock(&other.lock);
+
+		// keep the rest of the stolen indices
+		pthread_mutex_lock(&mine.lock);
+		mine.lo = lo+1;
+		mine.hi = hi;
+		pthread_mutex_unlock(&mine.lock);
+		return lo;
+	}
+	return -1;
+}
+
+void WorkPool::work(int w)
+{
+	for (int i = next(w); i >= 0; i = next(w))
+		task_(arg_, i, w);
+}
+
+// static method
+void* WorkPool::thread(void* arg)
+{
+	Start* s = static_cast<Start*>(arg);
+	WorkPool* pool = s->pool;
+	int w = s->w;
+	delete s;
+
+	unsigned gen = 0;
+	while (true)
+	{
+		// wait for the next run
+		pthread_mutex_lock(&pool->lock_);
+		while (pool->gen_ == gen && !pool->quit_)
+			pthread_cond_wait(&pool->start_, &pool->lock_);
+		if (pool->quit_)
+		{
+			pthread_mutex_unlock(&pool->lock_);
+			break;
+		}
+		gen = pool->gen_;
+		pthread_mutex_unlock(&pool->lock_);
+
+		pool->work(w);
+
+		pthread_mutex_lock(&pool->lock_);
+		if (--pool->busy_ == 0)
+			pthread_cond_signal(&pool->done_);
+		pthread_mutex_unlock(&pool->lock_);
+	}
+	return NULL;
+}
+
+void WorkPool::run(int N, TASK_T task, void* arg)
+{
+	assert(N >= 0);
+	assert(task);
+	task_ = task;
+	arg_ = arg;
+
+	// give each worker an equal share
+	// (the workers are idle, so the ranges can be set without locking)
+	for (int w = 0; w < size_; w++)
+	{
+		ranges_[w].lo = (int)((long long)N * w / size_);
+		ranges_[w].hi = (int)((long long)N * (w+1) / size_);
+	}
+
+	if (size_ > 1)
+	{
+		pthread_mutex_lock(&lock_);
+		busy_ = size_-1;
+		gen_++;
+		pthread_cond_broadcast(&start_);
+		pthread_mutex_unlock(&lock_);
+	}
+
+	work(0);
+
+	if (size_ > 1)
+	{
+		pthread_mutex_lock(&lock_);
+		while (busy_ > 0)
+			pthread_cond_wait(&done_, &lock_);
+		pthread_mutex_unlock(&lock_);
+	}
+}
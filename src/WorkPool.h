@@ -0,0 +1,64 @@
+#ifndef WORKPOOL_H_
+#define WORKPOOL_H_
+
+#include <vector>
+#include <pthread.h>
+
+// A pool of threads that run a task for every index in [0,N).
+// Each thread starts with an equal share of the indices. When a thread runs
+// out of work, it steals half of the remaining indices from another thread.
+// The calling thread takes part as worker 0, so a pool of size 1 has no threads.
+class WorkPool
+{
+public:
+	// task(arg, i, w) runs index i on worker w
+	typedef void (*TASK_T)(void* arg, int i, int w);
+
+private:
+	// indices [lo,hi) that a worker still has to run
+	struct Range
+	{
+		pthread_mutex_t lock;
+		int lo, hi;
+	};
+
+	int size_;
+	std::vector<Range> ranges_;
+	std::vector<pthread_t> threads_;
+
+	// current run
+	TASK_T task_;
+	void* arg_;
+
+	// wake up workers for a new run, and wait for them to finish
+	pthread_mutex_t lock_;
+	pthread_cond_t start_;
+	pthread_cond_t done_;
+	unsigned gen_;
+	int busy_;
+	bool quit_;
+
+	// take the next index of worker w (stealing if needed), or -1 if there is none
+	int next(int w);
+	// run all indices that are left (as worker w)
+	void work(int w);
+
+	struct Start { WorkPool* pool; int w; };
+	static void* thread(void* arg);
+
+	WorkPool(const WorkPool&);
+	WorkPool& operator=(const WorkPool&);
+
+public:
+	// Nworkers includes the calling thread
+	WorkPool(int Nworkers);
+	~WorkPool();
+
+	// number of workers
+	int size() const { return size_; }
+
+	// run task for each index in [0,N) and wait until all are done
+	void run(int N, TASK_T task, void* arg);
+};
+
+#endif // WORKPOOL_H_
@@ -28,3 +28,14 @@
 
 // miscellaneous
 #include "VCDWriter.h"			// Write VCD (waveform) files
+#include "Netlist.h"			// Flattened (compiled) simulation
+#include "SimContext.h"			// Per-thread simulation state
+#include "PartitionSim.h"		// Partitioned parallel simulation
+#include "PatternSim.h"			// 64-pattern functional simulation
+#include "LevelSim.h"			// Levelized zero-delay simulation
+#include "Kernels.h"			// Batched (SIMD) gate evaluation kernels
+#include "DelayCache.h"		// Delay tables of system modules
+#include "StaticTiming.h"		// Static timing analysis
+#include "PowerTrace.h"		// Time-binned power traces
+#include "PowerReport.h"		// Per-module power and activity
+#include "PowerEstimate.h"		// Power estimates without simulation
@@ -0,0 +1,71 @@
+#ifndef JOBPOOL_H_
+#define JOBPOOL_H_
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+
+// Run independent jobs on all cores.
+// job(j, out) is called once for each j in [0,Njobs), on any thread.
+// Each job writes to its own buffer, and the buffers are printed in job order,
+// so the output does not depend on the number of threads.
+// Jobs that simulate use their thread's default SimContext.
+typedef void (*JOB_T)(int j, std::ostream& out);
+
+struct JobPool
+{
+	JOB_T job;
+	int Njobs;
+	int next;
+	pthread_mutex_t lock;
+	std::vector<std::ostringstream*> outs;
+
+	static void* worker(void* arg)
+	{
+		JobPool* pool = static_cast<JobPool*>(arg);
+		while (true)
+		{
+			// take the next job
+			pthread_mutex_lock(&pool->lock);
+			int j = pool->next++;
+			pthread_mutex_unlock(&pool->lock);
+			if (j >= pool->Njobs) break;
+
+			pool->job(j, *pool->outs[j]);
+		}
+		return NULL;
+	}
+};
+
+inline void runJobs(int Njobs, JOB_T job, std::ostream& out=std::cout)
+{
+	JobPool pool;
+	pool.job = job;
+	pool.Njobs = Njobs;
+	pool.next = 0;
+	pthread_mutex_init(&pool.lock, NULL);
+	for (int j = 0; j < Njobs; j++)
+		pool.outs.push_back(new std::ostringstream());
+
+	int Nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (Nthreads < 1) Nthreads = 1;
+	if (Nthreads > Njobs) Nthreads = Njobs;
+
+	std::vector<pthread_t> threads(Nthreads);
+	for (int t = 0; t < Nthreads; t++)
+		pthread_create(&threads[t], NULL, JobPool::worker, &pool);
+	for (int t = 0; t < Nthreads; t++)
+		pthread_join(threads[t], NULL);
+
+	// print results in order
+	for (int j = 0; j < Njobs; j++)
+	{
+		out << pool.outs[j]->str();
+		delete pool.outs[j];
+	}
+	pthread_mutex_destroy(&pool.lock);
+}
+
+#endif // JOBPOOL_H_
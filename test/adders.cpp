@@ -34,7 +34,7 @@ void testAdder(Adder& adder, value_t x, value_t y, Bit c)
 
 	// compute average/peak power of the simulation
 	energy_t avgpow, maxpow;
-	adder.simPowerStats(&avgpow, &maxpow);
+	SimContext::current().powerStats(&avgpow, &maxpow);
 	cout << "Avg. power: " << avgpow << endl;
 	cout << "Peak power: " << maxpow << endl;
 	cout << endl;
@@ -1,10 +1,15 @@
 #include <iostream>
+#include <cstdlib>
 #include "sim.h"
+#include "JobPool.h"
 using namespace std;
 
+// seed for random inputs (each adder gets its own sequence)
+static unsigned seed0;
+
 // Simulate an adder 1024 times with random inputs.
 // Report the delay, area, and power stats.
-void testAdder(Adder& adder)
+void testAdder(Adder& adder, unsigned seed, ostream& out)
 {
 	// Static computations of area and critical path.
 	area_t area = adder.area();
@@ -14,15 +19,15 @@ void testAdder(Adder& adder)
 	energy_t Etot = 0;
 	energy_t Ppeak = 0;
 
-	cout << adder << endl;
-	cout << "WIDTH,CRIT_DELAY,MAX_DELAY,AREA,AVG_POW,PEAK_POW" << endl;
+	out << adder << endl;
+	out << "WIDTH,CRIT_DELAY,MAX_DELAY,AREA,AVG_POW,PEAK_POW" << endl;
 
 	// Simulate with random inputs
 	for (int i = 0; i < 1024; i++)
 	{
-		value_t x = random();
-		value_t y = random();
-		Bit c = random() & 1;
+		value_t x = rand_r(&seed);
+		value_t y = rand_r(&seed);
+		Bit c = rand_r(&seed) & 1;
 
 		adder("X") <= x;
 		adder("Y") <= y;
@@ -36,7 +41,7 @@ void testAdder(Adder& adder)
 
 		// record power
 		energy_t avgpow, peakpow;
-		adder.simPowerStats(&avgpow, &peakpow);
+		SimContext::current().powerStats(&avgpow, &peakpow);
 		Etot += avgpow * T;
 		if (peakpow > Ppeak) Ppeak = peakpow;
 
@@ -45,31 +50,32 @@ void testAdder(Adder& adder)
 
 	// print stats
 	energy_t avgpow = Etot / Ttot;
-	cout << adder.width() << "," << Tcrit << "," << Tmax << "," << area << "," << avgpow << "," << Ppeak << endl;
+	out << adder.width() << "," << Tcrit << "," << Tmax << "," << area << "," << avgpow << "," << Ppeak << endl;
 }
 
-int main(int argc, char** argv)
+// 5 adder types for each width
+void testJob(int j, ostream& out)
 {
-	srandom(time(NULL));
+	int i = 8 << (j / 5);
+	unsigned seed = seed0 + j;
 
-	// simulate various adder types with increasing input width
-	for (int i = 8; i <= 64; i *= 2)
+	switch (j % 5)
 	{
-		RippleAdder cra(i);
-		testAdder(cra);
-
-		SkipAdder csk(i,i/4);
-		testAdder(csk);
-
-		SelectAdder csel(i,LookaheadAdder(i/4));
-		testAdder(csel);
+	case 0: { RippleAdder cra(i); testAdder(cra, seed, out); break; }
+	case 1: { SkipAdder csk(i,i/4); testAdder(csk, seed, out); break; }
+	case 2: { SelectAdder csel(i,LookaheadAdder(i/4)); testAdder(csel, seed, out); break; }
+	case 3: { LookaheadAdder cla(i,LookaheadAdder(i/4)); testAdder(cla, seed, out); break; }
+	case 4: { PrefixAdder pre(i); testAdder(pre, seed, out); break; }
+	}
+}
 
-		LookaheadAdder cla(i,LookaheadAdder(i/4));
-		testAdder(cla);
+int main(int argc, char** argv)
+{
+	seed0 = time(NULL);
 
-		PrefixAdder pre(i);
-		testAdder(pre);
-	}
+	// simulate various adder types with increasing input width (8 to 64)
+	// (the adders are simulated in parallel)
+	runJobs(4*5, testJob);
 
 	return 0;
 }
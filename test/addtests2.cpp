@@ -1,24 +1,29 @@
 #include <iostream>
+#include <cstdlib>
 #include "sim.h"
+#include "JobPool.h"
 using namespace std;
 
+// seed for random inputs (each adder gets its own sequence)
+static unsigned seed0;
+
 // Simulate an adder 1024 times with random inputs.
 // Report the delay/area/power stats.
-void testAdder(Adder& adder)
+void testAdder(Adder& adder, unsigned seed, ostream& out)
 {
 	area_t area = adder.area();
 	delay_t Tcrit = adder.criticalPath();
 	delay_t Ttot = 0;
 	energy_t Etot = 0;
 
-	cout << adder << endl;
-	cout << "CRIT_DELAY,AREA,AVG_POW" << endl;
+	out << adder << endl;
+	out << "CRIT_DELAY,AREA,AVG_POW" << endl;
 
 	for (int i = 0; i < 1024; i++)
 	{
-		value_t x = random();
-		value_t y = random();
-		Bit c = random() & 1;
+		value_t x = rand_r(&seed);
+		value_t y = rand_r(&seed);
+		Bit c = rand_r(&seed) & 1;
 
 		adder("X") <= x;
 		adder("Y") <= y;
@@ -29,47 +34,54 @@ void testAdder(Adder& adder)
 		Ttot += T;
 
 		energy_t avgpow, peakpow;
-		adder.simPowerStats(&avgpow, &peakpow);
+		SimContext::current().powerStats(&avgpow, &peakpow);
 		Etot += avgpow * T;
 
 		adder.reset();
 	}
 
 	energy_t avgpow = Etot / Ttot;
-	cout << Tcrit << "," << area << "," << avgpow << endl << endl;
+	out << Tcrit << "," << area << "," << avgpow << endl << endl;
 }
 
-int main(int argc, char** argv)
-{
-	srandom(time(NULL));
+// 64-bit adders
+const int N = 64;
 
-	// 64-bit adders
-	const int N = 64;
+void testJob(int j, ostream& out)
+{
+	unsigned seed = seed0 + j;
 
 	// Carry-ripple (for comparison)
+	if (j == 0)
 	{
 	RippleAdder cra(N);
-	testAdder(cra);
+	testAdder(cra, seed, out);
+	return;
 	}
 
 	// Various adders using CLA sub-adders
-	for (int m = 4; m <= 32; m *= 2)
+	if (j <= 12)
 	{
+	int m = 4 << ((j-1) / 3);
 	LookaheadAdder subcla(N/m);
 
-	RippleAdder cra(N,subcla);
-	testAdder(cra);
-
-	SelectAdder csel(N,subcla);
-	testAdder(csel);
-
-	LookaheadAdder cla(N,subcla);
-	testAdder(cla);
+	switch ((j-1) % 3)
+	{
+	case 0: { RippleAdder cra(N,subcla); testAdder(cra, seed, out); break; }
+	case 1: { SelectAdder csel(N,subcla); testAdder(csel, seed, out); break; }
+	case 2: { LookaheadAdder cla(N,subcla); testAdder(cla, seed, out); break; }
+	}
+	return;
 	}
 
+	switch (j)
+	{
 	// Prefix adder
+	case 13: {
 	PrefixAdder pre(N);
-	testAdder(pre);
+	testAdder(pre, seed, out);
+	break;
+	}
 
 	// Hierarchical CLAs
 
@@ -78,23 +90,44 @@ int main(int argc, char** argv)
 	//  8 groups of 8
 	//  4 groups of 16
 	//  2 groups of 32
+	case 14: {
 	LookaheadAdder cla2(64, LookaheadAdder(32, LookaheadAdder(16,
 						LookaheadAdder(8, LookaheadAdder(4, LookaheadAdder(2))))));
-	testAdder(cla2);
+	testAdder(cla2, seed, out);
+	break;
+	}
 
 	// 16 groups of 4
 	//  8 groups of 8
 	//  4 groups of 16
+	case 15: {
 	LookaheadAdder cla4(64, LookaheadAdder(16, LookaheadAdder(4)));
-	testAdder(cla4);
+	testAdder(cla4, seed, out);
+	break;
+	}
 
 	// 8 groups of 8
+	case 16: {
 	LookaheadAdder cla8(64, LookaheadAdder(8));
-	testAdder(cla8);
+	testAdder(cla8, seed, out);
+	break;
+	}
 
 	// 4 groups of 16
+	case 17: {
 	LookaheadAdder cla16(64, LookaheadAdder(16));
-	testAdder(cla16);
+	testAdder(cla16, seed, out);
+	break;
+	}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	seed0 = time(NULL);
+
+	// the adders are simulated in parallel
+	runJobs(18, testJob);
 
 	return 0;
 }
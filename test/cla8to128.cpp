@@ -21,7 +21,7 @@ void testAdder(Adder& adder)
 		Ttot += T;
 
 		energy_t avgpow, peakpow;
-		adder.simPowerStats(&avgpow,&peakpow);
+		SimContext::current().powerStats(&avgpow, &peakpow);
 		Etot += avgpow * T;
 		if (peakpow > Pmax) Pmax = peakpow;
 
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <cstdlib>
+#include "sim.h"
+using namespace std;
+
+// Measure elaboration time: building, finalizing and deleting each of the
+// 64-bit adder configurations of addtests2.cpp.
+// The number of times each adder is built can be given as an argument.
+
+// get current time in seconds
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME,&ts);
+	return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
+
+// 64-bit adders
+const int N = 64;
+const int Nconfigs = 18;
+
+// build configuration j (same numbering as addtests2.cpp)
+static Adder* buildAdder(int j)
+{
+	if (j == 0)
+		return new RippleAdder(N);
+
+	if (j <= 12)
+	{
+		int m = 4 << ((j-1) / 3);
+		LookaheadAdder subcla(N/m);
+		switch ((j-1) % 3)
+		{
+		case 0: return new RippleAdder(N,subcla);
+		case 1: return new SelectAdder(N,subcla);
+		case 2: return new LookaheadAdder(N,subcla);
+		}
+	}
+
+	switch (j)
+	{
+	case 13: return new PrefixAdder(N);
+	case 14: return new LookaheadAdder(64, LookaheadAdder(32, LookaheadAdder(16,
+					LookaheadAdder(8, LookaheadAdder(4, LookaheadAdder(2))))));
+	case 15: return new LookaheadAdder(64, LookaheadAdder(16, LookaheadAdder(4)));
+	case 16: return new LookaheadAdder(64, LookaheadAdder(8));
+	case 17: return new LookaheadAdder(64, LookaheadAdder(16));
+	}
+	return NULL;
+}
+
+int main(int argc, char** argv)
+{
+	int R = 10;
+	if (argc > 1) R = atoi(argv[1]);
+	assert(R > 0);
+
+	double tbuild = 0, tfinal = 0, tdelete = 0;
+	cout << "ADDER,BUILD_MS,FINALIZE_MS,DELETE_MS" << endl;
+	for (int j = 0; j < Nconfigs; j++)
+	{
+		double tb = 0, tf = 0, td = 0;
+		Adder* adder = NULL;
+		for (int r = 0; r < R; r++)
+		{
+			double T0 = now();
+			adder = buildAdder(j);
+			double T1 = now();
+			adder->finalize();
+			double T2 = now();
+			if (r == R-1) cout << *adder;
+			delete adder;
+			double T3 = now();
+			tb += T1-T0;
+			tf += T2-T1;
+			td += T3-T2;
+		}
+		cout << "," << 1e3*tb/R << "," << 1e3*tf/R << "," << 1e3*td/R << endl;
+		tbuild += tb;
+		tfinal += tf;
+		tdelete += td;
+	}
+
+	cout << "Total (" << R << " times each): build " << tbuild << "s, finalize "
+	     << tfinal << "s, delete " << tdelete << "s" << endl;
+	return 0;
+}
@@ -0,0 +1,293 @@
+#include <iostream>
+#include <vector>
+#include "sim.h"
+using namespace std;
+
+// Compare the compiled netlist simulator with the Module simulator.
+// After simulating the same inputs, every wire must have the same history.
+
+typedef vector<HPAIR_T> HLIST_T;
+
+// get current time in seconds
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME,&ts);
+	return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
+
+// copy the history of every net
+static void snapshot(const Netlist& nl, vector<HLIST_T>& hists)
+{
+	int N = nl.numNets();
+	hists.assign(N, HLIST_T());
+	for (int n = 0; n < N; n++)
+		hists[n].assign(nl.net(n)->histBegin(), nl.net(n)->histEnd());
+}
+
+// copy the whole state (history of every net)
+static void save(const Netlist& nl, vector<BitHistory>& state)
+{
+	int N = nl.numNets();
+	state.assign(N, BitHistory());
+	for (int n = 0; n < N; n++)
+	{
+		nl.net(n)->swapHistory(state[n]);
+		BitHistory h = state[n];
+		nl.net(n)->swapHistory(h);
+	}
+}
+
+// go back to a saved state
+static void restore(const Netlist& nl, const vector<BitHistory>& state)
+{
+	int N = nl.numNets();
+	for (int n = 0; n < N; n++)
+	{
+		BitHistory h = state[n];
+		nl.net(n)->swapHistory(h);
+	}
+}
+
+// context that propagates each time step with several threads
+static SimContext* threaded;
+
+// simulate the current state with all simulators
+// (returns false if any history is different)
+static bool check(Module& top, const Netlist& nl, NetlistSim& sim, PartitionSim& psim,
+                  double* t1=NULL, double* t2=NULL, double* t3=NULL, double* t4=NULL)
+{
+	vector<BitHistory> state;
+	save(nl, state);
+
+	double T0 = now();
+	top.simulate();
+	double T1 = now();
+
+	vector<HLIST_T> expected, actual, parallel, partitioned;
+	snapshot(nl, expected);
+
+	// same state again
+	restore(nl, state);
+
+	double T2 = now();
+	sim.simulate();
+	double T3 = now();
+
+	snapshot(nl, actual);
+	restore(nl, state);
+
+	double T4 = now();
+	top.simulate(*threaded);
+	double T5 = now();
+
+	snapshot(nl, parallel);
+	restore(nl, state);
+
+	double T6 = now();
+	psim.simulate();
+	double T7 = now();
+
+	snapshot(nl, partitioned);
+
+	if (t1) *t1 += T1 - T0;
+	if (t2) *t2 += T3 - T2;
+	if (t3) *t3 += T5 - T4;
+	if (t4) *t4 += T7 - T6;
+	return expected == actual && expected == parallel && expected == partitioned;
+}
+
+// simulate an adder with random inputs
+static bool testAdder(Adder& adder, int iters)
+{
+	Netlist nl(adder);
+	NetlistSim sim(nl);
+	PartitionSim psim(nl, threaded->threads(), threaded->threads());
+	int N = adder.width();
+	bool ok = true;
+	double tmod = 0, tnet = 0, tpar = 0, tpart = 0;
+
+	for (int i = 0; i < iters && ok; i++)
+	{
+		adder("X") <= BitVector::random(N);
+		adder("Y") <= BitVector::random(N);
+		adder("Ci") <= Bit::random();
+		ok = check(adder, nl, sim, psim, &tmod, &tnet, &tpar, &tpart);
+		adder.reset();
+	}
+
+	cout << adder << ": " << nl.numCells() << " cells, " << nl.numNets() << " nets, "
+	     << (ok ? "OK" : "FAILED") << " (" << tmod << "s module, " << tnet << "s netlist, " << tpar << "s threads, "
+	     << tpart << "s partitioned)" << endl;
+	return ok;
+}
+
+// simulate two adders in separate contexts, a few steps at a time
+// (must give the same histories as simulating them one after the other)
+static bool testContexts(Adder& a, Adder& b, int iters)
+{
+	Netlist na(a), nb(b);
+	bool ok = true;
+
+	for (int i = 0; i < iters && ok; i++)
+	{
+		a("X") <= BitVector::random(a.width());
+		a("Y") <= BitVector::random(a.width());
+		b("X") <= BitVector::random(b.width());
+		b("Y") <= BitVector::random(b.width());
+
+		vector<BitHistory> sa, sb;
+		save(na, sa);
+		save(nb, sb);
+		a.simulate();
+		b.simulate();
+		vector<HLIST_T> ea, eb;
+		snapshot(na, ea);
+		snapshot(nb, eb);
+		restore(na, sa);
+		restore(nb, sb);
+
+		SimContext ca, cb;
+		MSET_T ra, rb;
+		ra.insert(&a);
+		rb.insert(&b);
+		Module::simStart(ca, ra, 10);
+		Module::simStart(cb, rb, 10);
+		while (ca.pending() || cb.pending())
+		{
+			if (ca.pending()) Module::simStep(ca, 10);
+			if (cb.pending()) Module::simStep(cb, 10);
+		}
+		vector<HLIST_T> aa, ab;
+		snapshot(na, aa);
+		snapshot(nb, ab);
+		ok = (ea == aa) && (eb == ab);
+
+		a.reset();
+		b.reset();
+	}
+
+	cout << "Interleaved contexts " << a << ", " << b << ": " << (ok ? "OK" : "FAILED") << endl;
+	return ok;
+}
+
+// two adders, the second one adds Y and Ci again
+// (its X input is connected later, see chain)
+class AdderPair : public SystemModule
+{
+private:
+	RippleAdder a_, b_;
+
+public:
+	AdderPair(int N) : a_(N), b_(N)
+	{
+		addInput("X", N);
+		addInput("Y", N);
+		addInput("Ci");
+		addOutput("S", N);
+		setClassname("AdderPair");
+		submodule(&a_);
+		submodule(&b_);
+
+		IN("X") >> a_("X");
+		IN("Y") >> a_("Y");
+		IN("Ci") >> a_("Ci");
+		IN("Y") >> b_("Y");
+		IN("Ci") >> b_("Ci");
+		OUT("S") << b_("S");
+	}
+
+	void chain()
+	{
+		a_("S") >> b_("X");
+	}
+};
+
+// simulate levelized, connect another wire, and simulate again
+// (the levelized copy must follow the new connection)
+static bool testRewire(int iters)
+{
+	AdderPair p(16);
+	SimContext lev;
+	lev.useMode(SIMMODE_LEVELIZED);
+	bool ok = true;
+
+	p("X") <= BitVector::random(16);
+	p("Y") <= BitVector::random(16);
+	p("Ci") <= Bit::random();
+	p.simulate(lev);
+	p.reset();
+	p.chain();
+
+	for (int i = 0; i < iters && ok; i++)
+	{
+		BitVector X = BitVector::random(16), Y = BitVector::random(16);
+		Bit Ci = Bit::random();
+		p("X") <= X;
+		p("Y") <= Y;
+		p("Ci") <= Ci;
+		p.simulate();
+		BitVector expected = p.getVector("S");
+		p.reset();
+
+		p("X") <= X;
+		p("Y") <= Y;
+		p("Ci") <= Ci;
+		p.simulate(lev);
+		ok = (p.getVector("S") == expected);
+		p.reset();
+	}
+
+	cout << "Levelized after rewiring " << p << ": " << (ok ? "OK" : "FAILED") << endl;
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	int L = (argc > 1) ? atoi(argv[1]) : 17;
+	int Nthreads = (argc > 2) ? atoi(argv[2]) : 4;
+	bool ok = true;
+	srandom(1);
+
+	threaded = new SimContext();
+	threaded->useThreads(Nthreads);
+
+	{ RippleAdder a(16); ok &= testAdder(a, 100); }
+	{ SkipAdder a(16,4); ok &= testAdder(a, 100); }
+	{ SelectAdder a(32,LookaheadAdder(8)); ok &= testAdder(a, 100); }
+	{ LookaheadAdder a(64,LookaheadAdder(16,LookaheadAdder(4))); ok &= testAdder(a, 100); }
+	{ RippleAdder a(32,LookaheadAdder(4)); ok &= testAdder(a, 100); }
+	{ PrefixAdder a(128); ok &= testAdder(a, 100); }
+	{ PrefixAdder a(32); LookaheadAdder b(32,LookaheadAdder(8)); ok &= testContexts(a, b, 20); }
+	ok &= testRewire(20);
+
+	// large random gate tree
+	{
+		RandomTree tree(L);
+
+		double T0 = now();
+		Netlist nl(tree);
+		double T1 = now();
+		NetlistSim sim(nl);
+		PartitionSim psim(nl, Nthreads, Nthreads);
+
+		double tmod = 0, tnet = 0, tpar = 0, tpart = 0;
+		bool treeok = check(tree, nl, sim, psim, &tmod, &tnet, &tpar, &tpart);
+		ok &= treeok;
+
+		cout << tree << ": " << nl.numCells() << " cells, " << nl.numNets() << " nets, "
+		     << (treeok ? "OK" : "FAILED") << endl;
+		cout << "Flatten time: " << (T1-T0) << " seconds." << endl;
+		cout << "Module simulation time: " << tmod << " seconds." << endl;
+		cout << "Netlist simulation time: " << tnet << " seconds." << endl;
+		cout << "Module simulation time with " << Nthreads << " threads: " << tpar << " seconds." << endl;
+		cout << "Partitioned simulation time with " << Nthreads << " threads: " << tpart << " seconds ("
+		     << psim.numCutNets() << " cut nets, " << psim.numRounds() << " rounds, "
+		     << psim.numMessages() << " messages)." << endl;
+	}
+
+	delete threaded;
+
+	cout << (ok ? "All engines agree." : "ENGINE MISMATCH") << endl;
+	return ok ? 0 : 1;
+}
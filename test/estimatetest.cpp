@@ -0,0 +1,212 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include "sim.h"
+using namespace std;
+
+// Check the power estimates (PowerEstimate) of the adders of addtests.cpp.
+// First, the exact probabilities of small adders against all of their input
+// vectors. Then the estimated average power of adders of 8 to 128 bits
+// against simulations of random vectors. The vectors are applied back to
+// back, one per clock period (addtests.cpp resets the adder before every
+// vector, so every output counts one new value there, and not only the ones
+// that change from the last vector).
+// The number of vectors can be given as an argument.
+
+// get current time in seconds
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME,&ts);
+	return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
+
+// Sets its outputs to a new vector every period (and costs no energy).
+class VectorSource : public Module
+{
+private:
+	vector<BitVector> vec_;
+	delay_t period_;
+
+public:
+	VectorSource(const vector<BitVector>& vec, delay_t period) :
+		 vec_(vec)
+		,period_(period)
+	{
+		std::stringstream ss;
+		ss << "VectorSource<" << vec[0].width() << ">";
+		setClassname(ss.str());
+		addOutputs(vec[0].width());
+	}
+
+	void propagate()
+	{
+		for (int k = 0; k < (int)vec_.size(); k++)
+			for (int o = 0; o < numOutputs(); o++)
+				setOutput(o, vec_[k].get(o), 1 + k*period_);
+	}
+
+	delay_t delay(int inum, int onum)
+	{
+		assert(0);
+		return DELAY_T_MIN;
+	}
+
+	delay_t load(int inum) const
+	{
+		assert(0);
+		return 0;
+	}
+
+	energy_t energy(int onum) const
+	{
+		return 0;
+	}
+};
+
+// net of each top-level output
+static vector<int> outputNets(const Netlist& nl, Module& top)
+{
+	vector<int> nets(top.numOutputs(), -1);
+	for (int n = 0; n < nl.numNets(); n++)
+		for (int o = 0; o < top.numOutputs(); o++)
+			if (nl.net(n) == top.outputWire(o)) nets[o] = n;
+	return nets;
+}
+
+// probabilities of the outputs from exact cones, and from all input vectors
+// (weighted by the input probabilities, which are not 0.5 here)
+static bool testExact(Adder& adder)
+{
+	int N = adder.width();
+	int Nin = adder.numInputs();
+	Netlist nl(adder);
+	PowerEstimate est(nl);
+	vector<double> prob(Nin);
+	for (int i = 0; i < Nin; i++)
+	{
+		prob[i] = 0.2 + 0.6 * i / Nin;
+		est.setInput(i, prob[i], 0.5);
+	}
+	est.useExact(Nin);
+	est.estimate();
+	vector<int> nets = outputNets(nl, adder);
+
+	// inputs are X, Y and Ci, at bits 0..N-1, N..2N-1 and 2N of v
+	PatternSim sim(nl);
+	int Nvec = 1 << Nin;
+	// S and Co (some adders also have group outputs)
+	vector<double> high(N+1, 0);
+	for (int v0 = 0; v0 < Nvec; v0 += 64)
+	{
+		for (int k = 0; k < 64; k++)
+		{
+			value_t v = (v0 + k) % Nvec;
+			sim.setValue("X", k, v & ((1 << N) - 1));
+			sim.setValue("Y", k, (v >> N) & ((1 << N) - 1));
+			sim.setValue("Ci", k, v >> (2*N));
+		}
+		sim.simulate();
+		for (int k = 0; k < 64 && v0 + k < Nvec; k++)
+		{
+			double w = 1;
+			for (int i = 0; i < Nin; i++)
+				w *= (((v0 + k) >> i) & 1) ? prob[i] : 1 - prob[i];
+			value_t S = sim.getValue("S", k);
+			for (int i = 0; i < N; i++)
+				if ((S >> i) & 1) high[i] += w;
+			if (sim.getValue("Co", k) & 1) high[N] += w;
+		}
+	}
+
+	bool ok = true;
+	double maxerr = 0;
+	for (int o = 0; o <= N; o++)
+	{
+		assert(nets[o] >= 0);
+		double err = fabs(est.probability(nets[o]) - high[o]);
+		maxerr = max(maxerr, err);
+		if (err > 1e-9) ok = false;
+	}
+	cout << adder << ": exact probabilities " << (ok ? "OK" : "FAILED") << " (" << est.numExact()
+	     << " of " << nl.numCells() << " cells exact, max. error " << maxerr << ")" << endl;
+	return ok;
+}
+
+// average power of Nvec random vectors, estimated and simulated
+static bool testPower(Adder& adder, int Nvec, ostream& out)
+{
+	double T0 = now();
+	Netlist nl(adder);
+	PowerEstimate est(nl);
+	est.estimate();
+	double T1 = now();
+
+	vector<BitVector> vec;
+	int Nin = adder.numInputs();
+	for (int k = 0; k < Nvec; k++)
+	{
+		BitVector v(Nin);
+		for (int i = 0; i < Nin; i++)
+			v.set(i, Bit::random());
+		vec.push_back(v);
+	}
+	delay_t period = adder.criticalPath() + 1;
+	VectorSource src(vec, period);
+	for (int i = 0; i < Nin; i++)
+		src.connect(i, &adder, i);
+
+	SimContext ctx;
+	ctx.useHistory(SIMHISTORY_STREAM);
+	double T2 = now();
+	src.simulate(ctx);
+	double T3 = now();
+
+	// the first vector starts from undefined values
+	double Psim = ctx.energy() / ((double)Nvec * period);
+	double Pest = est.power(period);
+	double err = Pest / Psim - 1;
+	bool ok = fabs(err) < 0.25;
+	out << adder.width() << "," << Psim << "," << Pest << "," << 100*err << "%," << (T1-T0) << "s," << (T3-T2) << "s"
+	    << (ok ? "" : " FAILED") << endl;
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	int Nvec = 500;
+	if (argc > 1) Nvec = atoi(argv[1]);
+	assert(Nvec > 0);
+	srandom(1);
+
+	bool ok = true;
+	{ RippleAdder a(4); ok &= testExact(a); }
+	{ SkipAdder a(4,2); ok &= testExact(a); }
+	{ SelectAdder a(4,LookaheadAdder(2)); ok &= testExact(a); }
+	{ LookaheadAdder a(4,LookaheadAdder(2)); ok &= testExact(a); }
+	{ PrefixAdder a(6); ok &= testExact(a); }
+	cout << endl;
+
+	for (int j = 0; j < 5; j++)
+	{
+		for (int i = 8; i <= 128; i *= 2)
+		{
+			stringstream ss;
+			switch (j)
+			{
+			case 0: { RippleAdder a(i); if (i == 8) cout << a << endl; ok &= testPower(a, Nvec, ss); break; }
+			case 1: { SkipAdder a(i,i/4); if (i == 8) cout << a << endl; ok &= testPower(a, Nvec, ss); break; }
+			case 2: { SelectAdder a(i,LookaheadAdder(i/4)); if (i == 8) cout << a << endl; ok &= testPower(a, Nvec, ss); break; }
+			case 3: { LookaheadAdder a(i,LookaheadAdder(i/4)); if (i == 8) cout << a << endl; ok &= testPower(a, Nvec, ss); break; }
+			case 4: { PrefixAdder a(i); if (i == 8) cout << a << endl; ok &= testPower(a, Nvec, ss); break; }
+			}
+			if (i == 8) cout << "WIDTH,SIM_POW,EST_POW,ERROR,EST_TIME,SIM_TIME" << endl;
+			cout << ss.str();
+		}
+	}
+
+	cout << (ok ? "All estimates agree." : "ESTIMATE MISMATCH") << endl;
+	return ok ? 0 : 1;
+}
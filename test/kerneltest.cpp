@@ -0,0 +1,146 @@
+#include <iostream>
+#include <vector>
+#include "sim.h"
+using namespace std;
+
+// Check the batched gate kernels of every instruction set supported by this
+// CPU against the evaluate64() of the same modules, and measure how many
+// gates per second each one evaluates.
+// The number of 64-lane words per batch can be given as an argument.
+
+// get current time in seconds
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME,&ts);
+	return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
+
+// N words of lanes for each of `count` signals
+struct Signals
+{
+	vector< vector<uint64_t> > val, def;
+	vector<Lanes> lanes;
+
+	Signals(int count, int N) : val(count, vector<uint64_t>(N)), def(count, vector<uint64_t>(N)), lanes(count)
+	{
+		for (int i = 0; i < count; i++)
+			lanes[i] = Lanes(&val[i][0], &def[i][0]);
+	}
+
+	Bit64 get(int i, int w) const { return Bit64(val[i][w], def[i][w]); }
+};
+
+// one kernel and the module it must agree with
+struct KernelTest
+{
+	const char* name;
+	KERNEL_T GateKernels::*kernel;
+	Module* module;
+};
+
+static bool testKernel(const GateKernels& kern, const KernelTest& test, int N, double* rate)
+{
+	Module& m = *test.module;
+	int Nin = m.numInputs(), Nout = m.numOutputs();
+	KERNEL_T f = kern.*test.kernel;
+
+	// random inputs (about 1 in 8 lanes undefined)
+	Signals in(Nin, N), out(Nout, N);
+	for (int i = 0; i < Nin; i++)
+	{
+		for (int w = 0; w < N; w++)
+		{
+			Bit64 b = Bit64::random();
+			Bit64 u = Bit64::random() & Bit64::random() & Bit64::random();
+			in.val[i][w] = b.val & ~u.val;
+			in.def[i][w] = ~u.val;
+		}
+	}
+
+	f(N, &in.lanes[0], &out.lanes[0]);
+
+	bool ok = true;
+	vector<Bit64> x(Nin), z(Nout);
+	for (int w = 0; w < N && ok; w++)
+	{
+		for (int i = 0; i < Nin; i++) x[i] = in.get(i, w);
+		m.evaluate64(&x[0], &z[0]);
+		for (int o = 0; o < Nout; o++)
+			if (z[o] != out.get(o, w)) ok = false;
+	}
+
+	// time enough batches for about 0.05s
+	int reps = 1;
+	double T = 0;
+	while (T < 0.05)
+	{
+		reps *= 2;
+		double T0 = now();
+		for (int r = 0; r < reps; r++)
+			f(N, &in.lanes[0], &out.lanes[0]);
+		T = now() - T0;
+	}
+	*rate = 64.0 * N * reps / T;
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	int N = (argc > 1) ? atoi(argv[1]) : 1024;
+	if (N < 1)
+	{
+		cout << "Usage: " << argv[0] << " [words]" << endl;
+		return -1;
+	}
+	srandom(1);
+
+	KernelTest tests[] = {
+		{ "AND",  &GateKernels::AND,  new AND() },
+		{ "OR",   &GateKernels::OR,   new OR() },
+		{ "XOR",  &GateKernels::XOR,  new XOR() },
+		{ "NAND", &GateKernels::NAND, new NAND() },
+		{ "NOR",  &GateKernels::NOR,  new NOR() },
+		{ "XNOR", &GateKernels::XNOR, new XNOR() },
+		{ "INV",  &GateKernels::INV,  new INV(1) },
+		{ "BUF",  &GateKernels::BUF,  new BUF(1) },
+		{ "MUX",  &GateKernels::MUX,  new MUX(1) },
+		{ "FA",   &GateKernels::FA,   new FA() },
+		{ "HA",   &GateKernels::HA,   new HA() },
+		{ "GP",   &GateKernels::GP,   new GP() },
+		{ "GAP",  &GateKernels::GAP,  new GAP(1) },
+	};
+	int Ntests = sizeof(tests) / sizeof(tests[0]);
+
+	cout << "Best kernels: " << GateKernels::best().isa << endl;
+	cout << "Gates/second with " << N << " words (" << 64*N << " lanes) per batch:" << endl;
+	cout << "ISA";
+	for (int t = 0; t < Ntests; t++)
+		cout << "," << tests[t].name;
+	cout << endl;
+
+	bool ok = true;
+	for (int k = 0; k < GateKernels::numSupported(); k++)
+	{
+		const GateKernels& kern = GateKernels::supported(k);
+		cout << kern.isa;
+		for (int t = 0; t < Ntests; t++)
+		{
+			double rate;
+			if (!testKernel(kern, tests[t], N, &rate))
+			{
+				cout << ",FAILED";
+				ok = false;
+			}
+			else
+				cout << "," << rate;
+		}
+		cout << endl;
+	}
+
+	for (int t = 0; t < Ntests; t++)
+		delete tests[t].module;
+
+	cout << (ok ? "All kernels agree." : "KERNEL MISMATCH") << endl;
+	return ok ? 0 : 1;
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cstring>
 #include "sim.h"
 using namespace std;
 
@@ -6,13 +7,33 @@ int main(int argc, char** argv)
 {
 	if (argc < 2)
 	{
-		cout << "Usage: " << argv[0] << " levels" << endl;
+		cout << "Usage: " << argv[0] << " levels [set|wheel] [stream] [threads=N]" << endl;
 		return -1;
 	}
 
 	int L = atoi(argv[1]);
 	RandomTree tree(L);
 
+	// optionally choose the simulation queue (default is the timing wheel)
+	// the wire history mode (default is full history)
+	// and the number of threads per time step (default is 1)
+	for (int i = 2; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "set"))
+			Module::simUseQueue(SIMQUEUE_SET);
+		else if (!strcmp(argv[i], "wheel"))
+			Module::simUseQueue(SIMQUEUE_WHEEL);
+		else if (!strcmp(argv[i], "stream"))
+			Module::simUseHistory(SIMHISTORY_STREAM);
+		else if (!strncmp(argv[i], "threads=", 8) && atoi(argv[i]+8) > 0)
+			Module::simUseThreads(atoi(argv[i]+8));
+		else
+		{
+			cout << "Unknown option: " << argv[i] << endl;
+			return -1;
+		}
+	}
+
 	cout << "Simulating random gate tree with " << L << " levels..." << endl;
 
 	struct timespec ts1,ts2;
@@ -0,0 +1,233 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cmath>
+#include "sim.h"
+using namespace std;
+
+// Check the power stats that are accumulated during simulation (SimContext)
+// against the ones computed from the wire histories (Module::simPowerStats).
+// Each adder gets random input vectors, simulated with full history, with
+// streaming history (no histories to scan), with parallel steps, and in
+// steps of a few time units. All of them must give the same power, and the
+// same as a PowerTrace of all the vectors, and as the activity of their
+// modules (PowerReport of an ActivityTable).
+// Then a register that toggles every clock cycle is simulated with a trace of
+// one bin per cycle (written as CSV and binary), without histories.
+
+// get current time in seconds
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME,&ts);
+	return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
+
+// same up to float rounding (the energies are added in a different order)
+static bool close(energy_t a, energy_t b)
+{
+	return fabs(a - b) <= 1e-5 * fabs(b);
+}
+
+static void setInputs(Adder& adder, const vector<BitVector>& vec, int k)
+{
+	adder("X") <= vec[3*k];
+	adder("Y") <= vec[3*k+1];
+	adder("Ci") <= vec[3*k+2];
+}
+
+// (the activity of all the runs is counted in `activity`)
+static bool testAdder(Adder& adder, int Nvec, ActivityTable& activity)
+{
+	int N = adder.width();
+	vector<BitVector> vec;
+	for (int k = 0; k < Nvec; k++)
+	{
+		vec.push_back(BitVector::random(N));
+		vec.push_back(BitVector::random(N));
+		vec.push_back(BitVector(Bit::random()));
+	}
+
+	bool ok = true;
+	double tctx = 0, thist = 0;
+	vector<energy_t> avg(Nvec), peak(Nvec);
+	activity.clear();
+	SimContext full;
+	PowerTrace trace;
+	full.useTrace(&trace);
+	full.useActivity(&activity);
+	energy_t Epeak = 0;
+	double Etot = 0;
+	for (int k = 0; k < Nvec; k++)
+	{
+		setInputs(adder, vec, k);
+		adder.simulate(full);
+		Etot += full.energy();
+		if (full.peakPower() > Epeak) Epeak = full.peakPower();
+
+		double T0 = now();
+		full.powerStats(&avg[k], &peak[k]);
+		double T1 = now();
+		energy_t avg2, peak2;
+		adder.simPowerStats(&avg2, &peak2);
+		double T2 = now();
+		tctx += T1 - T0;
+		thist += T2 - T1;
+
+		if (!close(avg[k], avg2) || !close(peak[k], peak2)) ok = false;
+		adder.reset();
+	}
+	if (trace.peakPower() != Epeak || !close(trace.energy(), Etot)) ok = false;
+
+	// the activity of the modules adds up to the same energy, by group and by class
+	PowerReport report(adder, activity);
+	double Egroups = 0, Eclasses = 0;
+	unsigned long Tgroups = 0, Tclasses = 0;
+	for (size_t k = 0; k < report.root().children.size(); k++)
+	{
+		Egroups += report.root().children[k].energy;
+		Tgroups += report.root().children[k].toggles;
+	}
+	for (size_t k = 0; k < report.classes().size(); k++)
+	{
+		Eclasses += report.classes()[k].energy;
+		Tclasses += report.classes()[k].toggles;
+	}
+	if (!close(report.energy(), Etot) || !close(Egroups, Etot) || !close(Eclasses, Etot)
+	    || Tgroups != report.toggles() || Tclasses != report.toggles())
+		ok = false;
+
+	// the same vectors with the other settings
+	SimContext stream;
+	stream.useHistory(SIMHISTORY_STREAM);
+	SimContext parallel;
+	parallel.useThreads(4);
+	SimContext* contexts[] = {&stream, &parallel};
+	for (int c = 0; c < 2; c++)
+	{
+		contexts[c]->useActivity(&activity);
+		for (int k = 0; k < Nvec; k++)
+		{
+			setInputs(adder, vec, k);
+			adder.simulate(*contexts[c]);
+			if (contexts[c]->averagePower() != avg[k] || contexts[c]->peakPower() != peak[k])
+				ok = false;
+			adder.reset();
+		}
+	}
+
+	// a few time units at a time
+	SimContext steps;
+	steps.useActivity(&activity);
+	MSET_T roots;
+	roots.insert(&adder);
+	for (int k = 0; k < Nvec; k++)
+	{
+		setInputs(adder, vec, k);
+		Module::simStart(steps, roots, 7);
+		while (steps.pending())
+			Module::simStep(steps, 7);
+		if (steps.averagePower() != avg[k] || steps.peakPower() != peak[k])
+			ok = false;
+		steps.reset();
+		adder.reset();
+	}
+
+	cout << adder << ": " << (ok ? "OK" : "FAILED") << " (per vector: context "
+	     << tctx/Nvec << "s, history scan " << thist/Nvec << "s)" << endl;
+	return ok;
+}
+
+// Ncycles of a register whose outputs are inverted back to its inputs,
+// traced to `out` in bins of one clock period
+static bool testClock(int Ncycles, powertrace_t format, ostream& out, PowerTrace& trace)
+{
+	const int N = 16;
+	const delay_t period = 100;
+	CLK clk(Ncycles, period/2, period/2);
+	REG reg(N);
+	INV inv(N);
+	clk.connect(0, &reg, N);
+	for (int i = 0; i < N; i++)
+	{
+		reg.connect(i, &inv, i);
+		inv.connect(i, &reg, i);
+		inv.setOutput(i, Bit(LOW), 0);
+	}
+
+	SimContext ctx;
+	ctx.useHistory(SIMHISTORY_STREAM);
+	ctx.useTrace(&trace);
+	trace.open(out, format);
+	double T0 = now();
+	clk.simulate(ctx);
+	double T1 = now();
+	trace.close();
+
+	// the peak window is at least the average of all bins
+	energy_t Pavg = trace.energy() / (trace.numBins() * trace.binWidth());
+	bool ok = close(trace.energy(), ctx.energy()) && trace.peakPower() >= Pavg;
+	cout << "CLK/REG<" << N << ">, " << Ncycles << " cycles: " << (ok ? "OK" : "FAILED")
+	     << " (" << trace.numBins() << " bins, peak power " << trace.peakPower() << " at T="
+	     << trace.peakTime() << ", avg. power " << ctx.averagePower() << ", " << (T1-T0) << "s)" << endl;
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	int Nvec = 64;
+	if (argc > 1) Nvec = atoi(argv[1]);
+	assert(Nvec > 0);
+	srandom(1);
+
+	bool ok = true;
+	ActivityTable activity;
+	for (int i = 8; i <= 64; i *= 2)
+	{
+		{ RippleAdder a(i); ok &= testAdder(a, Nvec, activity); }
+		{ SkipAdder a(i,i/4); ok &= testAdder(a, Nvec, activity); }
+		{ SelectAdder a(i,LookaheadAdder(i/4)); ok &= testAdder(a, Nvec, activity); }
+		{ LookaheadAdder a(i,LookaheadAdder(i/4)); ok &= testAdder(a, Nvec, activity); }
+		{
+			PrefixAdder a(i);
+			ok &= testAdder(a, Nvec, activity);
+			// where the power goes (over all the runs)
+			if (i == 64)
+			{
+				cout << endl;
+				PowerReport(a, activity).print(cout, 5, 3);
+				cout << endl;
+			}
+		}
+	}
+
+	// the same run, traced to CSV and binary
+	int Ncycles = 5000;
+	stringstream csv, bin;
+	PowerTrace trace(100, 4);
+	ok &= testClock(Ncycles, POWERTRACE_CSV, csv, trace);
+	PowerTrace trace2(100, 4);
+	ok &= testClock(Ncycles, POWERTRACE_BINARY, bin, trace2);
+
+	// the CSV has the energy of every bin, and the binary file has as many records
+	string line;
+	getline(csv, line);
+	int lines = 0;
+	double Ecsv = 0;
+	while (getline(csv, line))
+	{
+		delay_t T;
+		double E, P;
+		char c1, c2;
+		stringstream ss(line);
+		ss >> T >> c1 >> E >> c2 >> P;
+		Ecsv += E;
+		lines++;
+	}
+	bool filesOk = close(Ecsv, trace.energy()) && (int)bin.str().size() == 12 + 8*lines;
+	cout << "Trace files: " << lines << " bins, " << (filesOk ? "OK" : "FAILED") << endl;
+	ok &= filesOk;
+
+	cout << (ok ? "All power stats agree." : "POWER MISMATCH") << endl;
+	return ok ? 0 : 1;
+}
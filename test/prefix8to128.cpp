@@ -25,7 +25,7 @@ int main(void)
 			Ttot += T;
 
 			energy_t avgpow, peakpow;
-			adder.simPowerStats(&avgpow,&peakpow);
+			SimContext::current().powerStats(&avgpow, &peakpow);
 			Etot += avgpow * T;
 			if (peakpow > Pmax) Pmax = peakpow;
 
@@ -0,0 +1,177 @@
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include "sim.h"
+using namespace std;
+
+// Static timing analysis of large adders: time the analysis and the top-K
+// path search, and check the paths (longest first, the first one is the
+// critical delay, the stages add up, and the stages on it have zero slack).
+// Then edit the timing graphs at random, and check the incremental update()
+// against the full analysis.
+// The number of paths and the number of threads can be given as arguments.
+
+// get current time in seconds
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME,&ts);
+	return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
+
+static bool testAdder(Adder& adder, int K, int threads, bool print)
+{
+	double T0 = now();
+	Netlist nl(adder);
+	double T1 = now();
+	StaticTiming sta(nl, threads);
+	double T2 = now();
+	vector<TimingPath> paths;
+	sta.topPaths(K, paths);
+	double T3 = now();
+
+	bool ok = !paths.empty() && paths[0].delay == sta.criticalDelay();
+	for (size_t k = 0; k < paths.size(); k++)
+	{
+		const TimingPath& p = paths[k];
+		if (k > 0 && p.delay > paths[k-1].delay) ok = false;
+		delay_t T = 0;
+		for (size_t s = 0; s < p.stages.size(); s++)
+		{
+			T += p.stages[s].delay;
+			if (T != p.stages[s].arrival) ok = false;
+			// every net on a critical path has zero slack
+			if (p.delay == sta.criticalDelay())
+			{
+				const TimingStage& st = p.stages[s];
+				int n = nl.outputNet(nl.firstOutput(st.cell) + st.onum);
+				if (sta.slack(n) != 0) ok = false;
+			}
+		}
+		if (T != p.delay) ok = false;
+	}
+
+	cout << adder << ": " << nl.numCells() << " cells, critical delay " << sta.criticalDelay()
+	     << ", " << (ok ? "OK" : "FAILED") << " (flatten " << (T1-T0) << "s, analyze "
+	     << (T2-T1) << "s, " << paths.size() << " paths " << (T3-T2) << "s)" << endl;
+	if (print && !paths.empty())
+		sta.printPath(cout, paths[0]);
+	return ok;
+}
+
+// a random edit: a slower arc, a cell replaced by another cell of the same
+// shape, or an input moved to an earlier net (or disconnected)
+static void randomEdit(const Netlist& nl, StaticTiming& sta)
+{
+	int C = nl.numCells();
+	int c = random() % C;
+	int Nin = nl.numInputs(c);
+	int Nout = nl.numOutputs(c);
+	if (Nin == 0 || Nout == 0) return;
+	int i = random() % Nin;
+
+	switch (random() % 3)
+	{
+	case 0:
+	{
+		int o = random() % Nout;
+		delay_t d = sta.getDelay(c, i, o);
+		if (d > 0) sta.setDelay(c, i, o, d + 1 + random() % 20);
+		break;
+	}
+	case 1:
+	{
+		int c2 = random() % C;
+		if (nl.numInputs(c2) == Nin && nl.numOutputs(c2) == Nout)
+			sta.replaceCell(c, *nl.cell(c2));
+		break;
+	}
+	default:
+		if (random() % 8 == 0)
+		{
+			sta.connect(c, i, -1);
+			break;
+		}
+		// nets of lower levels keep the netlist free of loops
+		for (int tries = 0; tries < 100; tries++)
+		{
+			int c2 = random() % C;
+			if (sta.level(c2) >= sta.level(c) || nl.numOutputs(c2) == 0) continue;
+			sta.connect(c, i, nl.outputNet(nl.firstOutput(c2) + random() % nl.numOutputs(c2)));
+			break;
+		}
+		break;
+	}
+}
+
+// edit the timing graph, and check update() against a full analyze()
+static bool testEdits(Adder& adder, int rounds, int edits)
+{
+	Netlist nl(adder);
+	StaticTiming sta(nl);
+	int N = nl.numNets();
+
+	bool ok = true;
+	long count = 0;
+	double tupdate = 0, tanalyze = 0;
+	vector<delay_t> arrival(N), required(N);
+	for (int r = 0; r < rounds; r++)
+	{
+		for (int k = 0; k < edits; k++)
+			randomEdit(nl, sta);
+
+		double T0 = now();
+		count += sta.update();
+		int i1, o1;
+		delay_t T = sta.criticalPath(&i1, &o1);
+		double T1 = now();
+		for (int n = 0; n < N; n++)
+		{
+			arrival[n] = sta.arrival(n);
+			required[n] = sta.required(n);
+		}
+
+		double T2 = now();
+		sta.analyze();
+		int i2, o2;
+		delay_t T_full = sta.criticalPath(&i2, &o2);
+		double T3 = now();
+		tupdate += T1 - T0;
+		tanalyze += T3 - T2;
+
+		if (T != T_full || i1 != i2 || o1 != o2) ok = false;
+		for (int n = 0; n < N; n++)
+			if (arrival[n] != sta.arrival(n) || required[n] != sta.required(n))
+				ok = false;
+	}
+
+	cout << adder << ": " << rounds << "x" << edits << " edits, " << (ok ? "OK" : "FAILED")
+	     << " (" << count/rounds << " cells+nets updated of " << nl.numCells() + N
+	     << ", update " << tupdate/rounds << "s, analyze " << tanalyze/rounds << "s)" << endl;
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	int K = 10;
+	int threads = 1;
+	if (argc > 1) K = atoi(argv[1]);
+	if (argc > 2) threads = atoi(argv[2]);
+	assert(K > 0 && threads > 0);
+
+	bool ok = true;
+	{ PrefixAdder a(16); ok &= testAdder(a, K, threads, true); }
+	{ RippleAdder a(1024); ok &= testAdder(a, K, threads, false); }
+	{ PrefixAdder a(1024); ok &= testAdder(a, K, threads, false); }
+	{ LookaheadAdder a(1024, LookaheadAdder(32, LookaheadAdder(4))); ok &= testAdder(a, K, threads, false); }
+	{ SelectAdder a(1024, LookaheadAdder(64, LookaheadAdder(8))); ok &= testAdder(a, K, threads, false); }
+
+	srandom(1);
+	{ LookaheadAdder a(64, LookaheadAdder(8)); ok &= testEdits(a, 200, 1); }
+	{ PrefixAdder a(1024); ok &= testEdits(a, 50, 1); }
+	{ LookaheadAdder a(1024, LookaheadAdder(32, LookaheadAdder(4))); ok &= testEdits(a, 50, 1); }
+	{ SelectAdder a(1024, LookaheadAdder(64, LookaheadAdder(8))); ok &= testEdits(a, 50, 4); }
+
+	cout << (ok ? "All paths agree." : "PATH MISMATCH") << endl;
+	return ok ? 0 : 1;
+}